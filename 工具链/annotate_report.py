@@ -0,0 +1,201 @@
+"""为仓库中的每个`.pyx`生成`cython -a`的注释,统计每个函数中与python交互的行(黄色的行),
+并检查热点函数的循环体中是否调用了python的C API.
+
+`cython -a`给每一行打的分数把异常处理路径也算在内,比如`boundscheck`越界时抛出异常,
+`prange`中出错时重新获取GIL,这些代码正常执行时走不到.
+因此检查热点函数时会解析每一行对应的C代码,去掉错误处理分支后再查找python的C API调用.
+
++ 注释输出到临时目录,不会覆盖仓库中的`.c`/`.cpp`文件
++ `# distutils: language=c++`的文件以`--cplus`转译
++ 所在目录或上级目录有`build_profiles.py`时使用其中`release`配置的转译指令
+
+热点函数的循环体中存在python调用时以状态码1退出.
+
+用法:
+    python annotate_report.py [--root 仓库根目录] [--hot 函数名 ...] [--html-dir 保存html的目录]
+"""
+import argparse
+import html
+import importlib.util
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+from dataclasses import dataclass, field
+from pathlib import Path
+
+DEFAULT_HOT = ["_normalize", "_median_along_axis0", "l2norm"]
+
+LINE_RE = re.compile(
+    r'<pre class="cython line score-(\d+)"[^>]*>.*?<span class="">(\d+)</span>:.*?</pre>'
+    r"\s*(?:<pre class='cython code[^>]*>(.*?)</pre>)?",
+    re.S,
+)
+DEF_RE = re.compile(r"^(\s*)(?:async\s+)?(?:def|cdef|cpdef)\s+(?:[\w\[\]\.:,*& ]+\s+)?\**(\w+)\s*\(")
+LOOP_RE = re.compile(r"^(\s*)(?:for|while)\b")
+PY_CALL_RE = re.compile(r"\b((?:Py|_Py|__Pyx_)\w+)\s*\(")
+# 只在错误处理,引用计数调试或者GIL切换中出现的辅助函数
+IGNORED_CALLS = re.compile(
+    r"^(?:__Pyx_(?:RefNanny\w*|X?GOTREF|X?GIVEREF|INCREF|DECREF|ErrFetch\w*|ErrRestore\w*|CppExn2PyErr|"
+    r"PyGILState_\w+|FastGIL_\w+|RaiseBufferIndexError\w*|AddTraceback)|PyGILState_\w+|PyMutex_\w+|"
+    r"PyEval_SaveThread|PyEval_RestoreThread)$"
+)
+
+
+@dataclass
+class Function:
+    name: str
+    start: int
+    end: int
+    loop_lines: set[int] = field(default_factory=set)
+
+
+def find_functions(source: list[str]) -> list[Function]:
+    """按缩进找出每个函数的行范围(从1开始)和其中循环体所在的行."""
+    functions = []
+    for index, text in enumerate(source):
+        match = DEF_RE.match(text)
+        if match is None or not text.rstrip().endswith(":"):
+            continue
+        indent = len(match.group(1))
+        end = len(source)
+        for j in range(index + 1, len(source)):
+            line = source[j]
+            if line.strip() and not line.lstrip().startswith("#") and len(line) - len(line.lstrip()) <= indent:
+                end = j
+                break
+        func = Function(match.group(2), index + 1, end)
+        for j in range(index + 1, end):
+            loop = LOOP_RE.match(source[j])
+            if loop is None:
+                continue
+            loop_indent = len(loop.group(1))
+            # 循环头也算在内,比如遍历python对象时每次迭代都要调用迭代器协议
+            func.loop_lines.add(j + 1)
+            for k in range(j + 1, end):
+                line = source[k]
+                if line.strip() and len(line) - len(line.lstrip()) <= loop_indent:
+                    break
+                func.loop_lines.add(k + 1)
+        functions.append(func)
+    return functions
+
+
+def hot_path_calls(code: str) -> list[str]:
+    """去掉错误处理分支后,返回C代码中调用的python C API."""
+    calls = []
+    skip_depth = None
+    depth = 0
+    for line in code.splitlines():
+        stripped = line.strip()
+        if re.match(r"__pyx_L\d+_error:", stripped):
+            # 错误标签之后都是异常处理路径
+            break
+        opening = skip_depth is None and (
+            stripped.startswith("} catch(") or stripped.startswith("catch(") or stripped.startswith("if (unlikely(")
+        )
+        if opening and stripped.endswith("{"):
+            skip_depth = depth
+        elif opening:
+            continue
+        if skip_depth is None:
+            # `x = PyXxx(...); if (unlikely(!x)) __PYX_ERR(...)`只保留错误检查之前的部分
+            code_line = line.split("if (unlikely(", 1)[0]
+            calls.extend(name for name in PY_CALL_RE.findall(code_line) if not IGNORED_CALLS.match(name))
+        depth += line.count("{") - line.count("}")
+        if skip_depth is not None and depth <= skip_depth:
+            skip_depth = None
+    return calls
+
+
+def profile_directives(pyx: Path, root: Path) -> dict:
+    for directory in pyx.parents:
+        config = directory / "build_profiles.py"
+        if config.exists():
+            spec = importlib.util.spec_from_file_location(f"build_profiles_{abs(hash(directory))}", config)
+            module = importlib.util.module_from_spec(spec)
+            spec.loader.exec_module(module)
+            return dict(module.PROFILES["release"]["directives"])
+        if directory == root:
+            break
+    return {}
+
+
+def annotate(pyx: Path, root: Path, outdir: Path) -> Path:
+    source = pyx.read_text(encoding="utf-8")
+    cplus = re.search(r"^#\s*distutils:\s*language\s*=\s*c\+\+", source, re.M) is not None
+    output = outdir / (pyx.stem + (".cpp" if cplus else ".c"))
+    cmd = [sys.executable, "-m", "cython", "-a", "-3", "-I", str(pyx.parent), "-o", str(output)]
+    if cplus:
+        cmd.append("--cplus")
+    directives = profile_directives(pyx, root)
+    if directives:
+        cmd += ["-X", ",".join(f"{key}={value}" for key, value in directives.items())]
+    cmd.append(str(pyx))
+    subprocess.run(cmd, check=True, capture_output=True, text=True)
+    return output.with_suffix(".html")
+
+
+def report(pyx: Path, html_path: Path, hot: set[str]) -> list[str]:
+    source = pyx.read_text(encoding="utf-8").splitlines()
+    lines = {}
+    for score, lineno, code in LINE_RE.findall(html_path.read_text(encoding="utf-8")):
+        lines[int(lineno)] = (int(score), html.unescape(re.sub(r"<[^>]+>", "", code or "")))
+    violations = []
+    for func in find_functions(source):
+        body = range(func.start, func.end + 1)
+        yellow = sum(1 for n in body if lines.get(n, (0, ""))[0] > 0)
+        marker = "*" if func.name in hot else " "
+        print(f"  {marker} {func.name:<32} lines {func.start:>4}-{func.end:<4} yellow {yellow:>3}/{len(body):<3}")
+        if func.name not in hot:
+            continue
+        for n in sorted(func.loop_lines):
+            calls = hot_path_calls(lines.get(n, (0, ""))[1])
+            if calls:
+                violations.append(f"{pyx}:{n}: {func.name} calls {', '.join(sorted(set(calls)))} inside a loop")
+    return violations
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--root", type=Path, default=Path(__file__).resolve().parent.parent, help="扫描的根目录")
+    parser.add_argument("--hot", nargs="*", default=DEFAULT_HOT, help="热点函数名")
+    parser.add_argument("--html-dir", type=Path, help="保留生成的html到这个目录")
+    args = parser.parse_args()
+
+    root = args.root.resolve()
+    hot = set(args.hot)
+    violations = []
+    failed = []
+    with tempfile.TemporaryDirectory(prefix="annotate-") as tmp:
+        for index, pyx in enumerate(sorted(root.rglob("*.pyx"))):
+            if "build" in pyx.relative_to(root).parts:
+                continue
+            print(pyx.relative_to(root))
+            outdir = Path(tmp) / str(index)
+            outdir.mkdir()
+            try:
+                html_path = annotate(pyx, root, outdir)
+            except subprocess.CalledProcessError as exc:
+                failed.append(f"{pyx.relative_to(root)}: {exc.stderr.strip().splitlines()[-1] if exc.stderr.strip() else exc}")
+                print("  cython failed")
+                continue
+            if args.html_dir is not None:
+                target = args.html_dir / pyx.relative_to(root).with_suffix(".html")
+                target.parent.mkdir(parents=True, exist_ok=True)
+                shutil.copy(html_path, target)
+            violations += report(pyx, html_path, hot)
+
+    if failed:
+        print(f"\n{len(failed)} files could not be annotated:")
+        print("\n".join(f"  {line}" for line in failed))
+    if violations:
+        print(f"\n{len(violations)} Python API calls inside loops of hot functions:")
+        print("\n".join(f"  {line}" for line in violations))
+        sys.exit(1)
+    print("\nno Python API calls inside loops of hot functions")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,64 @@
+"""对比原先逐项迭代的写法和`fib`模块中的快速倍增,序列填充.
+
+原先的`fib`用`a, b = b, a + b`逐项迭代,这里用同样的循环作为基准.
+需要先`cythonize -i -3 fib.pyx`.
+
+用法:
+    python bench_fib.py
+"""
+import time
+
+import fib
+
+
+def loop_nth(n: int) -> int:
+    a, b = 0, 1
+    for _ in range(n):
+        a, b = b, a + b
+    return a
+
+
+def loop_nth_mod(n: int, mod: int) -> int:
+    a, b = 0, 1
+    for _ in range(n):
+        a, b = b, (a + b) % mod
+    return a
+
+
+def loop_sequence(n: int, mod: int) -> list[int]:
+    out = [0] * n
+    a, b = 0, 1
+    for i in range(n):
+        out[i] = a
+        a, b = b, (a + b) % mod
+    return out
+
+
+def timeit(func, *args, repeat: int = 1) -> tuple[float, object]:
+    start = time.perf_counter()
+    for _ in range(repeat):
+        result = func(*args)
+    return (time.perf_counter() - start) / repeat, result
+
+
+def report(name: str, loop_case: tuple, engine_case: tuple) -> None:
+    (loop_cost, loop_result), (engine_cost, engine_result) = loop_case, engine_case
+    assert loop_result == engine_result, name
+    print(f"{name:<28} loop {loop_cost * 1e6:12.2f} us  engine {engine_cost * 1e6:10.2f} us  (x{loop_cost / engine_cost:.1f})")
+
+
+def main() -> None:
+    report("F(90)", timeit(loop_nth, 90, repeat=10000), timeit(fib.fib_nth, 90, repeat=10000))
+    report("F(100000)", timeit(loop_nth, 100000), timeit(fib.fib_nth, 100000))
+    report("F(10**6) mod 1e9+7", timeit(loop_nth_mod, 10**6, 1000000007),
+           timeit(fib.fib_nth, 10**6, 1000000007, repeat=10000))
+    mod = 1000000007
+    loop_case = timeit(loop_sequence, 10**6, mod)
+    cost, seq = timeit(fib.fib_sequence, 10**6, mod)
+    report("F(0..10**6) mod 1e9+7", loop_case, (cost, seq.tolist()))
+    rec = fib.LinearRecurrence([1, 1], [0, 1])
+    report("LinearRecurrence F(10**5)", timeit(loop_nth, 100000), timeit(rec.term, 100000))
+
+
+if __name__ == "__main__":
+    main()
@@ -1,10 +1,273 @@
 # distutils: language=c++
+# cython: language_level=3
 
-def fib(int n):
+cimport cython
+from libc.stdint cimport int64_t, uint64_t
+from libcpp.vector cimport vector
+
+import numpy as np
+
+
+cdef extern from *:
+    bint add_overflow "__builtin_add_overflow" (int64_t, int64_t, int64_t *) noexcept nogil
+    bint mul_overflow "__builtin_mul_overflow" (int64_t, int64_t, int64_t *) noexcept nogil
+
+
+# F(93)是uint64能表示的最大的斐波那契数
+cdef enum:
+    MAX_U64_INDEX = 93
+
+
+def fib(n):
     """Print the Fibonacci series up to n."""
-    cdef int a = 0
-    cdef int b = 1
+    cdef uint64_t a = 0
+    cdef uint64_t b = 1
+    # 先用64位整数,超出范围后再换成python的整数
     while b < n:
         print(b, end=' ')
+        if a > <uint64_t>-1 - b:
+            break
         a, b = b, a + b
+    else:
+        print()
+        return
+    pa, pb = b, <object>a + <object>b
+    while pb < n:
+        print(pb, end=' ')
+        pa, pb = pb, pa + pb
     print()
+
+
+cdef uint64_t _check_mod(mod) except 0:
+    if not 1 <= mod < 2 ** 32:
+        raise ValueError("mod must be in [1, 2**32)")
+    return mod
+
+
+cdef uint64_t _fib_c(uint64_t n, uint64_t m) noexcept nogil:
+    """快速倍增法计算F(n) mod m,m为0时按2**64取模."""
+    cdef uint64_t a = 0  # F(k)
+    cdef uint64_t b = 1  # F(k+1)
+    cdef uint64_t c, d
+    cdef int bit = 63
+    while bit >= 0 and not (n >> bit) & 1:
+        bit -= 1
+    while bit >= 0:
+        # F(2k) = F(k) * (2F(k+1) - F(k)), F(2k+1) = F(k)^2 + F(k+1)^2
+        if m:
+            c = a * ((2 * b + m - a) % m) % m
+            d = (a * a % m + b * b % m) % m
+        else:
+            c = a * (2 * b - a)
+            d = a * a + b * b
+        if (n >> bit) & 1:
+            a, b = d, c + d
+            if m:
+                b %= m
+        else:
+            a, b = c, d
+        bit -= 1
+    return a
+
+
+def _fib_big(n):
+    a, b = 0, 1
+    for bit in bin(n)[2:]:
+        c = a * (2 * b - a)
+        d = a * a + b * b
+        if bit == "1":
+            a, b = d, c + d
+        else:
+            a, b = c, d
+    return a
+
+
+def fib_nth(n, mod=None):
+    """Return F(n), or F(n) % mod, in O(log n) by fast doubling.
+
+    Only falls back to Python ints when the result does not fit in 64 bits.
+    """
+    if n < 0:
+        raise ValueError("n must be non-negative")
+    if mod is not None:
+        return _fib_c(n, _check_mod(mod))
+    if n <= MAX_U64_INDEX:
+        return _fib_c(n, 0)
+    return _fib_big(n)
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef void _fill_fib(uint64_t[::1] out, uint64_t m) noexcept nogil:
+    cdef Py_ssize_t i
+    if out.shape[0] > 0:
+        out[0] = 0
+    if out.shape[0] > 1:
+        out[1] = 1 % m if m else 1
+    for i in range(2, out.shape[0]):
+        out[i] = out[i - 1] + out[i - 2]
+        if m and out[i] >= m:
+            out[i] -= m
+
+
+def fib_sequence(Py_ssize_t n, mod=None, out=None):
+    """Return F(0), ..., F(n-1) in a uint64 NumPy array.
+
+    out, if given, must be a contiguous uint64 buffer of length n and is
+    filled in place. Without mod and with n > 94 the terms no longer fit in
+    64 bits, and a list of Python ints is returned instead.
+    """
+    cdef uint64_t m = 0
+    if n < 0:
+        raise ValueError("n must be non-negative")
+    if mod is not None:
+        m = _check_mod(mod)
+    elif n > MAX_U64_INDEX + 1:
+        head = fib_sequence(MAX_U64_INDEX + 1).tolist()
+        for _ in range(n - len(head)):
+            head.append(head[-1] + head[-2])
+        return head
+    if out is None:
+        out = np.empty(n, dtype=np.uint64)
+    cdef uint64_t[::1] buf = out
+    if buf.shape[0] != n:
+        raise ValueError("out must have length n")
+    _fill_fib(buf, m)
+    return out
+
+
+ctypedef vector[uint64_t] Matrix
+
+
+cdef Matrix _matmul_mod(const Matrix& x, const Matrix& y, Py_ssize_t k, uint64_t m) noexcept nogil:
+    cdef Matrix z = Matrix(k * k, 0)
+    cdef Py_ssize_t i, j, l
+    cdef uint64_t xil
+    for i in range(k):
+        for l in range(k):
+            xil = x[i * k + l]
+            if xil == 0:
+                continue
+            for j in range(k):
+                z[i * k + j] = (z[i * k + j] + xil * y[l * k + j]) % m
+    return z
+
+
+cdef class LinearRecurrence:
+    """a[n] = coeffs[0] * a[n-1] + ... + coeffs[k-1] * a[n-k] with a[0..k-1] = initial.
+
+    The Fibonacci numbers are LinearRecurrence([1, 1], [0, 1]).
+    """
+    cdef readonly tuple coeffs
+    cdef readonly tuple initial
+
+    def __init__(self, coeffs, initial):
+        self.coeffs = tuple(int(c) for c in coeffs)
+        self.initial = tuple(int(a) for a in initial)
+        if not self.coeffs or len(self.coeffs) != len(self.initial):
+            raise ValueError("coeffs and initial must be non-empty and have the same length")
+
+    def term(self, n, mod=None):
+        """Return a[n], or a[n] % mod, in O(k^3 log n) by powering the companion matrix."""
+        cdef Py_ssize_t k = len(self.coeffs)
+        if n < 0:
+            raise ValueError("n must be non-negative")
+        if n < k:
+            return self.initial[n] if mod is None else self.initial[n] % mod
+        if mod is None:
+            return self._term_big(n)
+        cdef uint64_t m = _check_mod(mod)
+        cdef uint64_t e = n - k + 1
+        cdef Matrix base = Matrix(k * k, 0)
+        cdef Matrix result = Matrix(k * k, 0)
+        cdef Py_ssize_t i
+        cdef uint64_t total = 0
+        # 伴随矩阵: 第一行是系数,其余是下移一位的单位阵
+        for i in range(k):
+            base[i] = self.coeffs[i] % m
+            result[i * k + i] = 1 % m
+        for i in range(1, k):
+            base[i * k + i - 1] = 1
+        with nogil:
+            while e:
+                if e & 1:
+                    result = _matmul_mod(result, base, k, m)
+                base = _matmul_mod(base, base, k, m)
+                e >>= 1
+        # 状态向量为(a[k-1], ..., a[0]),结果取第一个分量
+        for i in range(k):
+            total = (total + result[i] * <uint64_t>(self.initial[k - 1 - i] % m)) % m
+        return total
+
+    def _term_big(self, n):
+        k = len(self.coeffs)
+        base = [[0] * k for _ in range(k)]
+        base[0] = list(self.coeffs)
+        for i in range(1, k):
+            base[i][i - 1] = 1
+        result = [[int(i == j) for j in range(k)] for i in range(k)]
+
+        def matmul(x, y):
+            return [[sum(x[i][l] * y[l][j] for l in range(k)) for j in range(k)] for i in range(k)]
+
+        e = n - k + 1
+        while e:
+            if e & 1:
+                result = matmul(result, base)
+            base = matmul(base, base)
+            e >>= 1
+        return sum(result[0][i] * self.initial[k - 1 - i] for i in range(k))
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def sequence(self, Py_ssize_t n, mod=None, out=None):
+        """Return a[0], ..., a[n-1] in an int64 NumPy array.
+
+        With mod the terms are reduced modulo mod. Without mod the int64
+        buffer is filled until a term overflows, then the remaining terms
+        are computed with Python ints and a list is returned instead.
+        out, if given, must be a contiguous int64 buffer of length n.
+        """
+        cdef Py_ssize_t k = len(self.coeffs)
+        cdef Py_ssize_t i, j
+        cdef uint64_t m = 0
+        cdef int64_t acc, prod
+        cdef bint overflow = False
+        cdef vector[int64_t] c
+        if n < 0:
+            raise ValueError("n must be non-negative")
+        if mod is not None:
+            m = _check_mod(mod)
+            for j in range(k):
+                c.push_back(self.coeffs[j] % m)
+        else:
+            for j in range(k):
+                c.push_back(self.coeffs[j])
+        if out is None:
+            out = np.empty(n, dtype=np.int64)
+        cdef int64_t[::1] buf = out
+        if buf.shape[0] != n:
+            raise ValueError("out must have length n")
+        for i in range(min(n, k)):
+            buf[i] = self.initial[i] if not m else self.initial[i] % m
+        with nogil:
+            i = k
+            while i < n:
+                acc = 0
+                for j in range(k):
+                    if m:
+                        acc = <int64_t>((<uint64_t>acc + <uint64_t>c[j] * <uint64_t>buf[i - 1 - j]) % m)
+                    elif mul_overflow(c[j], buf[i - 1 - j], &prod) or add_overflow(acc, prod, &acc):
+                        overflow = True
+                        break
+                if overflow:
+                    break
+                buf[i] = acc
+                i += 1
+        if not overflow:
+            return out
+        # 溢出后改用python的整数继续计算
+        terms = [buf[j] for j in range(i)]
+        for i in range(i, n):
+            terms.append(sum(self.coeffs[j] * terms[i - 1 - j] for j in range(k)))
+        return terms
@@ -0,0 +1,34 @@
+"""对比逐个调用`lcmath.lfactorial`和一次调用`lcmath.lfactorial_array`计算一批log阶乘的耗时.
+
+需要先`cythonize -i -3 lcmath.pyx`.
+
+用法:
+    python bench_lcmath.py [元素个数,默认1000000]
+"""
+import sys
+import time
+from array import array
+
+import lcmath
+
+
+def main() -> None:
+    n = int(sys.argv[1]) if len(sys.argv) > 1 else 1000000
+    xs = array("d", (float(i % 10000) for i in range(n)))
+
+    start = time.perf_counter()
+    scalar = [lcmath.lfactorial(x) for x in xs]
+    scalar_cost = time.perf_counter() - start
+
+    out = array("d", bytes(8 * n))
+    start = time.perf_counter()
+    lcmath.lfactorial_array(xs, out)
+    array_cost = time.perf_counter() - start
+
+    assert all(abs(a - b) <= 1e-9 * max(1.0, abs(a)) for a, b in zip(scalar, out))
+    print(f"lfactorial       {scalar_cost * 1000:9.2f} ms  {n / scalar_cost / 1e6:8.2f} M/s")
+    print(f"lfactorial_array {array_cost * 1000:9.2f} ms  {n / array_cost / 1e6:8.2f} M/s  (x{scalar_cost / array_cost:.1f})")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,54 @@
+"""对比几种方式执行同一段调用cython模块的代码的启动耗时.
+
++ `python`,用普通的python解释器导入`cythonize -i`编译出的动态链接库
++ `mypython`,`cython_freeze --pymain`构造的自定义解释器
++ `fastpython`,`build_fastpython.sh`构造的静态解释器
+
+需要在freeze文件夹下执行,没有构造或者无法执行的解释器会被跳过.
+
+用法:
+    python bench_startup.py [执行次数,默认50]
+"""
+import os
+import statistics
+import subprocess
+import sys
+import time
+
+CODE = "from combinatorics import nCr; nCr(15812351235, 12)"
+
+
+def bench(cmd: list[str], n: int) -> list[float]:
+    cost = []
+    for _ in range(n):
+        start = time.perf_counter()
+        subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL)
+        cost.append((time.perf_counter() - start) * 1000)
+    return cost
+
+
+def main() -> None:
+    n = int(sys.argv[1]) if len(sys.argv) > 1 else 50
+    candidates = {
+        "python + .so": [sys.executable, "-c", CODE],
+        "mypython": ["../mypython", "-c", CODE],
+        "fastpython": ["../fastpython", "-c", CODE],
+    }
+    baseline = None
+    for name, cmd in candidates.items():
+        if cmd[0] != sys.executable and not os.access(cmd[0], os.X_OK):
+            print(f"{name:<14} skipped, {cmd[0]} not found")
+            continue
+        try:
+            cost = bench(cmd, n)
+        except (OSError, subprocess.CalledProcessError) as e:
+            # 比如提交的是其他平台构造的解释器,或者缺少依赖,只跳过这一项
+            print(f"{name:<14} skipped, {e}")
+            continue
+        median = statistics.median(cost)
+        baseline = baseline or median
+        print(f"{name:<14} median {median:7.2f} ms  min {min(cost):7.2f} ms  (x{baseline / median:.2f})")
+
+
+if __name__ == "__main__":
+    main()
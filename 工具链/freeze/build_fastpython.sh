@@ -0,0 +1,22 @@
+# 构造快速启动的静态解释器`fastpython`,需要在freeze文件夹下执行
+# PYTHON需要和链接的libpython版本一致,冻结的字节码和版本绑定
+PYTHON=${PYTHON:-python3}
+PY_INCLUDE=$($PYTHON -c 'import sysconfig;print(sysconfig.get_paths()["include"])')
+PY_LIBPL=$($PYTHON -c 'import sysconfig;print(sysconfig.get_config_var("LIBPL"))')
+PY_LDVERSION=$($PYTHON -c 'import sysconfig;print(sysconfig.get_config_var("LDVERSION"))')
+PY_SYSLIBS=$($PYTHON -c 'import sysconfig;print(sysconfig.get_config_var("LIBS"), sysconfig.get_config_var("SYSLIBS"))')
+
+# 1. 转译cython模块,并编译一份可以被python直接导入的动态链接库用于记录导入状态和对比测试
+cython -3 -o combinatorics.c combinatorics.pyx
+cython -3 -o lcmath.c lcmath.pyx
+cythonize -i -3 combinatorics.pyx lcmath.pyx
+
+# 2. 执行工作负载,冻结其中用到的纯python标准库模块
+$PYTHON freeze_snapshot.py -o frozen_snapshot.c -c "import combinatorics"
+
+# 3. 编译并静态链接libpython,`-export-dynamic`让之后加载的C扩展仍然可以找到python的符号
+gcc -O2 -I $PY_INCLUDE -c fastpython.c -o fastpython.o
+gcc -O2 -I $PY_INCLUDE -c frozen_snapshot.c -o frozen_snapshot.o
+gcc -O2 -fopenmp -I $PY_INCLUDE -c combinatorics.c -o combinatorics.o
+gcc -O2 -fopenmp -I $PY_INCLUDE -c lcmath.c -o lcmath.o
+gcc -fopenmp -o ../fastpython fastpython.o frozen_snapshot.o combinatorics.o lcmath.o $PY_LIBPL/libpython$PY_LDVERSION.a $PY_SYSLIBS -Xlinker -export-dynamic
@@ -1,15 +1,215 @@
 # cython: language_level=3
+# distutils: extra_compile_args=-fopenmp
+# distutils: extra_link_args=-fopenmp
 
-import lcmath
+cimport cython
+from cython.parallel cimport prange
+from cpython.array cimport array, clone
+from cpython.mem cimport PyMem_Malloc, PyMem_Free
+from libc.stdint cimport int64_t, uint64_t
+from lcmath cimport c_exp, lfactorial_c
 
+import math
 
-def nCr(n, r):
+
+cdef array _double_template = array("d")
+cdef array _int64_template = array("q")
+
+
+cdef inline double _lnCr(double n, double r) noexcept nogil:
+    return lfactorial_c(n) - lfactorial_c(r) - lfactorial_c(n - r)
+
+
+def nCr(double n, double r):
     """Return the number of ways to choose r elements of a set of n."""
-    return lcmath.exp(
-        lcmath.lfactorial(n) -
-        lcmath.lfactorial(r) -
-        lcmath.lfactorial(n-r)
-    )
+    return c_exp(_lnCr(n, r))
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def nCr_array(n, r, out=None):
+    """Return nCr for every pair of elements of the double buffers n and r."""
+    cdef const double[:] xn = n
+    cdef const double[:] xr = r
+    if xr.shape[0] != xn.shape[0]:
+        raise ValueError("n and r must have the same length")
+    if out is None:
+        out = clone(_double_template, xn.shape[0], False)
+    cdef double[:] y = out
+    if y.shape[0] != xn.shape[0]:
+        raise ValueError("out must have the same length as n")
+    cdef Py_ssize_t i
+    for i in prange(xn.shape[0], nogil=True, schedule="static"):
+        y[i] = c_exp(_lnCr(xn[i], xr[i]))
+    return out
+
+
+cdef inline uint64_t _powmod(uint64_t base, uint64_t exp, uint64_t m) noexcept nogil:
+    cdef uint64_t result = 1
+    base %= m
+    while exp:
+        if exp & 1:
+            result = result * base % m
+        base = base * base % m
+        exp >>= 1
+    return result
+
+
+cdef bint _is_prime(uint64_t m) noexcept nogil:
+    cdef uint64_t d = 2
+    if m < 2:
+        return False
+    while d * d <= m:
+        if m % d == 0:
+            return False
+        d += 1
+    return True
+
+
+cdef class BinomialTable:
+    """Precomputed tables for binomial coefficients with 0 <= n <= max_n.
+
+    Keeps log(i!) for float and log-space results. When mod is given (a prime
+    below 2**32 and greater than max_n) it also keeps i! and 1/i! modulo mod,
+    so nCr is exact modulo mod with two table lookups. Without mod, nCr is the
+    exact integer.
+    """
+    cdef readonly Py_ssize_t max_n
+    cdef readonly object mod
+    cdef uint64_t _m
+    cdef double *_lfact
+    cdef uint64_t *_fact
+    cdef uint64_t *_inv_fact
+
+    def __cinit__(self, Py_ssize_t max_n, mod=None):
+        cdef Py_ssize_t i
+        if max_n < 0:
+            raise ValueError("max_n must be non-negative")
+        self.max_n = max_n
+        self.mod = mod
+        self._lfact = <double *>PyMem_Malloc((max_n + 1) * sizeof(double))
+        if self._lfact is NULL:
+            raise MemoryError()
+        for i in range(max_n + 1):
+            self._lfact[i] = lfactorial_c(i)
+        if mod is None:
+            return
+        if not 1 < mod < 2 ** 32 or not _is_prime(mod):
+            raise ValueError("mod must be a prime in (1, 2**32)")
+        if max_n >= mod:
+            raise ValueError("max_n must be less than mod")
+        self._m = mod
+        self._fact = <uint64_t *>PyMem_Malloc((max_n + 1) * sizeof(uint64_t))
+        self._inv_fact = <uint64_t *>PyMem_Malloc((max_n + 1) * sizeof(uint64_t))
+        if self._fact is NULL or self._inv_fact is NULL:
+            raise MemoryError()
+        self._fact[0] = 1
+        for i in range(1, max_n + 1):
+            self._fact[i] = self._fact[i - 1] * i % self._m
+        # 费马小定理求最大的逆元,再向下递推
+        self._inv_fact[max_n] = _powmod(self._fact[max_n], self._m - 2, self._m)
+        for i in range(max_n, 0, -1):
+            self._inv_fact[i - 1] = self._inv_fact[i] * i % self._m
+
+    def __dealloc__(self):
+        PyMem_Free(self._lfact)
+        PyMem_Free(self._fact)
+        PyMem_Free(self._inv_fact)
+
+    cdef inline uint64_t _nCr_mod(self, int64_t n, int64_t r) noexcept nogil:
+        if r < 0 or r > n:
+            return 0
+        return self._fact[n] * self._inv_fact[r] % self._m * self._inv_fact[n - r] % self._m
+
+    cdef inline double _lnCr(self, int64_t n, int64_t r) noexcept nogil:
+        return self._lfact[n] - self._lfact[r] - self._lfact[n - r]
+
+    cdef int _check_n(self, int64_t n) except -1:
+        if n < 0 or n > self.max_n:
+            raise ValueError(f"n must be in [0, {self.max_n}], got {n}")
+        return 0
+
+    def nCr(self, int64_t n, int64_t r):
+        """Return the exact nCr, modulo mod if the table has one."""
+        self._check_n(n)
+        if self.mod is not None:
+            return self._nCr_mod(n, r)
+        if r < 0 or r > n:
+            return 0
+        return math.comb(n, r)
+
+    def lnCr(self, int64_t n, int64_t r):
+        """Return log(nCr) from the log-factorial table, -inf if r is out of [0, n]."""
+        self._check_n(n)
+        if r < 0 or r > n:
+            return float("-inf")
+        return self._lnCr(n, r)
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def nCr_array(self, n, r, out=None):
+        """Return nCr for every pair of elements of the int64 buffers n and r.
+
+        Results are int64 modulo mod if the table has one, otherwise float
+        approximations from the log-factorial table.
+        """
+        cdef const int64_t[:] xn = n
+        cdef const int64_t[:] xr = r
+        if xr.shape[0] != xn.shape[0]:
+            raise ValueError("n and r must have the same length")
+        cdef Py_ssize_t i
+        cdef int64_t bad = -1
+        for i in range(xn.shape[0]):
+            if xn[i] < 0 or xn[i] > self.max_n:
+                bad = i
+                break
+        if bad >= 0:
+            self._check_n(xn[bad])
+        cdef int64_t[:] yi
+        cdef double[:] yd
+        if self.mod is not None:
+            if out is None:
+                out = clone(_int64_template, xn.shape[0], False)
+            yi = out
+            if yi.shape[0] != xn.shape[0]:
+                raise ValueError("out must have the same length as n")
+            for i in prange(xn.shape[0], nogil=True, schedule="static"):
+                yi[i] = self._nCr_mod(xn[i], xr[i])
+        else:
+            if out is None:
+                out = clone(_double_template, xn.shape[0], False)
+            yd = out
+            if yd.shape[0] != xn.shape[0]:
+                raise ValueError("out must have the same length as n")
+            for i in prange(xn.shape[0], nogil=True, schedule="static"):
+                if xr[i] < 0 or xr[i] > xn[i]:
+                    yd[i] = 0
+                else:
+                    yd[i] = c_exp(self._lnCr(xn[i], xr[i]))
+        return out
+
+
+cdef dict _tables = {}
+
+
+def binomial_table(Py_ssize_t max_n, mod=None):
+    """Return a cached BinomialTable covering max_n, building a larger one if needed.
+
+    With mod the table can only cover n < mod (n! is 0 modulo mod beyond it),
+    so max_n >= mod raises ValueError.
+    """
+    if mod is not None and max_n >= mod:
+        raise ValueError(f"max_n must be less than mod, got {max_n} >= {mod}")
+    table = _tables.get(mod)
+    if table is None or table.max_n < max_n:
+        # 成倍扩大,避免n逐渐增大时反复重建,取模时不超过mod - 1
+        size = max_n if table is None else max(max_n, 2 * table.max_n)
+        if mod is not None:
+            size = min(size, mod - 1)
+        table = BinomialTable(size, mod)
+        _tables[mod] = table
+    return table
+
 
 if __name__ == "__main__":
     import sys
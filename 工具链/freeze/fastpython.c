@@ -0,0 +1,64 @@
+/*
+ * 快速启动的自定义python解释器
+ *
+ * 和`cython_freeze --pymain`生成的`mypython.c`作用相同,`combinatorics`和`lcmath`作为内置模块,
+ * 区别在于启动时尽量少做事:
+ *
+ * + 工作负载用到的纯python标准库模块由`freeze_snapshot.py`冻结进可执行文件,从内存加载
+ * + 不导入`site`,也就不扫描site-packages和`.pth`文件
+ * + 不把脚本所在目录加入`sys.path`
+ * + 链接静态的`libpython`,省去动态链接的开销
+ *
+ * 命令行参数和`python`一致,比如`./fastpython -c "from combinatorics import nCr"`.
+ */
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdio.h>
+
+#if PY_VERSION_HEX < 0x030B0000
+#error "fastpython.c requires Python 3.11+"
+#endif
+
+PyMODINIT_FUNC PyInit_combinatorics(void);
+PyMODINIT_FUNC PyInit_lcmath(void);
+
+/* 由freeze_snapshot.py生成 */
+extern const struct _frozen frozen_snapshot[];
+
+static struct _inittab inittab[] = {
+    {"combinatorics", PyInit_combinatorics},
+    {"lcmath", PyInit_lcmath},
+    {NULL, NULL}};
+
+int main(int argc, char** argv) {
+    PyStatus status;
+    PyConfig config;
+
+    PyImport_FrozenModules = frozen_snapshot;
+    if (PyImport_ExtendInittab(inittab)) {
+        fprintf(stderr, "No memory\n");
+        return 1;
+    }
+
+    PyConfig_InitPythonConfig(&config);
+    config.site_import = 0;
+    config.user_site_directory = 0;
+    config.safe_path = 1;
+    status = PyConfig_SetBytesArgv(&config, argc, argv);
+    if (PyStatus_Exception(status)) {
+        goto fail;
+    }
+    status = Py_InitializeFromConfig(&config);
+    if (PyStatus_Exception(status)) {
+        goto fail;
+    }
+    PyConfig_Clear(&config);
+    return Py_RunMain();
+
+fail:
+    PyConfig_Clear(&config);
+    if (PyStatus_IsExit(status)) {
+        return status.exitcode;
+    }
+    Py_ExitStatusException(status);
+}
@@ -0,0 +1,91 @@
+"""生成冻结的标准库模块表.
+
+运行一次代表性的工作负载,记录它导入了哪些模块(导入状态的快照),
+把其中纯python的标准库模块编译成字节码,以C数组的形式写入`frozen_snapshot.c`.
+`fastpython.c`启动时将`PyImport_FrozenModules`指向这张表,这些模块就直接从可执行文件中加载,
+不再需要在磁盘上查找,读取和反序列化`.pyc`.
+
+已经被解释器冻结的模块(比如`os`,`io`)和C扩展模块不会重复处理.
+字节码的格式和python版本绑定,因此这个文件需要用和链接时相同版本的python执行,只支持python 3.11及以上.
+
+用法:
+    python freeze_snapshot.py -o frozen_snapshot.c -c "import combinatorics"
+"""
+import argparse
+import marshal
+import subprocess
+import sys
+import sysconfig
+from pathlib import Path
+
+import _imp
+
+
+def snapshot_modules(code: str, cwd: str) -> list[str]:
+    """在不导入site的子进程中执行`code`,返回执行后`sys.modules`中的模块名."""
+    probe = f"import sys\n{code}\nsys.stdout.write('\\n'.join(sys.modules))\n"
+    out = subprocess.run([sys.executable, "-S", "-c", probe], cwd=cwd, check=True, capture_output=True, text=True)
+    return [line for line in out.stdout.splitlines() if line]
+
+
+def stdlib_source(name: str) -> tuple[Path, bool] | None:
+    """找到纯python标准库模块的源码,返回(源码路径, 是否为包),不满足条件的返回None."""
+    if name in sys.builtin_module_names or name in _imp._frozen_module_names():
+        return None
+    stdlib = Path(sysconfig.get_paths()["stdlib"])
+    relative = Path(*name.split("."))
+    package_init = stdlib / relative / "__init__.py"
+    if package_init.exists():
+        return package_init, True
+    module = stdlib.joinpath(relative).with_suffix(".py")
+    if module.exists():
+        return module, False
+    return None
+
+
+def c_array(name: str, data: bytes) -> str:
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ",".join(str(b) for b in data[i:i + 16]) + ",")
+    return f"static const unsigned char {name}[] = {{\n" + "\n".join(lines) + "\n};\n"
+
+
+def main() -> None:
+    # `_frozen`结构中的`is_package`字段和`_imp._frozen_module_names`都是3.11加入的
+    if sys.version_info < (3, 11):
+        sys.exit(f"freeze_snapshot.py requires Python 3.11+, got {sys.version.split()[0]}")
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("-o", "--output", default="frozen_snapshot.c", help="输出的C源文件")
+    parser.add_argument("-c", "--code", default="import combinatorics", help="代表性的工作负载")
+    parser.add_argument("--cwd", default=".", help="执行工作负载的目录,需要能导入其中的cython模块")
+    args = parser.parse_args()
+
+    frozen = []
+    for name in sorted(snapshot_modules(args.code, args.cwd)):
+        found = stdlib_source(name)
+        if found is None:
+            continue
+        path, is_package = found
+        code = compile(path.read_bytes(), f"<frozen {name}>", "exec", dont_inherit=True)
+        frozen.append((name, is_package, marshal.dumps(code)))
+
+    parts = [
+        f"/* Generated by freeze_snapshot.py with Python {sys.version.split()[0]}, do not edit. */\n",
+        "#include <Python.h>\n\n",
+        f"#if (PY_VERSION_HEX >> 16) != 0x{sys.hexversion >> 16:04X}\n",
+        f'#error "frozen_snapshot.c was generated for Python {sys.version_info[0]}.{sys.version_info[1]}, regenerate it"\n',
+        "#endif\n\n",
+    ]
+    for i, (name, _, data) in enumerate(frozen):
+        parts.append(f"/* {name} */\n")
+        parts.append(c_array(f"frozen_code_{i}", data))
+    parts.append("\nconst struct _frozen frozen_snapshot[] = {\n")
+    for i, (name, is_package, data) in enumerate(frozen):
+        parts.append(f'    {{"{name}", frozen_code_{i}, {len(data)}, {int(is_package)}}},\n')
+    parts.append("    {0, 0, 0},\n};\n")
+    Path(args.output).write_text("".join(parts))
+    print(f"froze {len(frozen)} modules: {' '.join(name for name, _, _ in frozen)}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,9 @@
+cdef extern from "math.h" nogil:
+    double c_lgamma "lgamma" (double)
+    double c_exp "exp" (double)
+    # lgamma会写全局变量signgam,并行时使用可重入的版本
+    double c_lgamma_r "lgamma_r" (double, int *)
+
+cdef inline double lfactorial_c(double n) noexcept nogil:
+    cdef int sign
+    return c_lgamma_r(n + 1, &sign)
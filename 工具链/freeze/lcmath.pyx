@@ -1,8 +1,10 @@
 # cython: language_level=3
+# distutils: extra_compile_args=-fopenmp
+# distutils: extra_link_args=-fopenmp
 
-cdef extern from "math.h":
-    double c_lgamma "lgamma" (double)
-    double c_exp "exp" (double)
+cimport cython
+from cython.parallel cimport prange
+from cpython.array cimport array, clone
 
 
 def exp(n):
@@ -20,6 +22,61 @@ def factorial(n):
     return c_exp( c_lgamma(n+1) )
 
 
+cdef array _double_template = array("d")
+
+
+cdef object _output_for(const double[:] x, out):
+    """Return `out`, or a new double array of the same length if it is None."""
+    if out is None:
+        return clone(_double_template, x.shape[0], False)
+    return out
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def exp_array(n, out=None):
+    """Return e**n for every element of the double buffer n."""
+    cdef const double[:] x = n
+    out = _output_for(x, out)
+    cdef double[:] y = out
+    if y.shape[0] != x.shape[0]:
+        raise ValueError("out must have the same length as n")
+    cdef Py_ssize_t i
+    for i in prange(x.shape[0], nogil=True, schedule="static"):
+        y[i] = c_exp(x[i])
+    return out
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def lfactorial_array(n, out=None):
+    """Return an estimate of the log factorial for every element of the double buffer n."""
+    cdef const double[:] x = n
+    out = _output_for(x, out)
+    cdef double[:] y = out
+    if y.shape[0] != x.shape[0]:
+        raise ValueError("out must have the same length as n")
+    cdef Py_ssize_t i
+    for i in prange(x.shape[0], nogil=True, schedule="static"):
+        y[i] = lfactorial_c(x[i])
+    return out
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def factorial_array(n, out=None):
+    """Return an estimate of the factorial for every element of the double buffer n."""
+    cdef const double[:] x = n
+    out = _output_for(x, out)
+    cdef double[:] y = out
+    if y.shape[0] != x.shape[0]:
+        raise ValueError("out must have the same length as n")
+    cdef Py_ssize_t i
+    for i in prange(x.shape[0], nogil=True, schedule="static"):
+        y[i] = c_exp(lfactorial_c(x[i]))
+    return out
+
+
 if __name__ == "__main__":
     import sys
     if len(sys.argv) != 2:
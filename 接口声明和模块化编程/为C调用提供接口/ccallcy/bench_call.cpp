@@ -0,0 +1,166 @@
+/**
+ * 对比C++调用`Vector.new(x, y).mod()`的两种方式的吞吐量
+ *
+ * + naive,每次调用都`PyObject_GetAttrString`查找`Vector`,`new`,`mod`,并用`PyTuple_Pack`构造参数
+ * + callsite,使用`VectorModCallSite`,只解析一次,之后用`PyObject_Vectorcall`调用
+ * + capi,使用`binary_vector_api.h`中`cdef api`导出的C函数,不经过python对象
+ *
+ * 另外用同样的Vectorcall调用路径对比三种引用计数的写法,衡量RAII的开销:
+ * + manual,手写`Py_DECREF`
+ * + guard,每个对象一个`sg::scope_guard`
+ * + pyref,`VectorModCallSite`中的`pyembed::PyRef`,即上面的callsite
+ *
+ * 用法: ./bench_call [调用次数,默认1000000]
+ */
+#include "pyembed.hpp"
+#include "scope_guard.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include "vector_callsite.hpp"
+#include "binary_vector.h"
+#include "binary_vector_api.h"
+
+double call_naive(PyObject* pModule, double x, double y) {
+    double result_double = -1.0;
+    auto pClaz = PyObject_GetAttrString(pModule, "Vector");
+    auto pClaz_new = pClaz ? PyObject_GetAttrString(pClaz, "new") : NULL;
+    auto pX = PyFloat_FromDouble(x);
+    auto pY = PyFloat_FromDouble(y);
+    auto args = PyTuple_Pack(2, pX, pY);
+    auto pObj = pClaz_new ? PyObject_Call(pClaz_new, args, NULL) : NULL;
+    auto pMethod = pObj ? PyObject_GetAttrString(pObj, "mod") : NULL;
+    auto margs = PyTuple_New(0);
+    auto result = pMethod ? PyObject_Call(pMethod, margs, NULL) : NULL;
+    if (result != NULL) {
+        result_double = PyFloat_AsDouble(result);
+    }
+    Py_XDECREF(result);
+    Py_DECREF(margs);
+    Py_XDECREF(pMethod);
+    Py_XDECREF(pObj);
+    Py_DECREF(args);
+    Py_DECREF(pY);
+    Py_DECREF(pX);
+    Py_XDECREF(pClaz_new);
+    Py_XDECREF(pClaz);
+    return result_double;
+}
+
+double call_manual(PyObject* pNew, PyObject* pModName, double x, double y) {
+    auto pX = PyFloat_FromDouble(x);
+    auto pY = PyFloat_FromDouble(y);
+    if (pX == NULL || pY == NULL) {
+        Py_XDECREF(pX);
+        Py_XDECREF(pY);
+        return -1.0;
+    }
+    PyObject* new_args[3] = {NULL, pX, pY};
+    auto pObj = PyObject_Vectorcall(pNew, new_args + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+    Py_DECREF(pX);
+    Py_DECREF(pY);
+    if (pObj == NULL) {
+        return -1.0;
+    }
+    PyObject* mod_args[2] = {NULL, pObj};
+    auto result = PyObject_VectorcallMethod(pModName, mod_args + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+    Py_DECREF(pObj);
+    if (result == NULL) {
+        return -1.0;
+    }
+    auto result_double = PyFloat_AsDouble(result);
+    Py_DECREF(result);
+    return result_double;
+}
+
+double call_guard(PyObject* pNew, PyObject* pModName, double x, double y) {
+    auto pX = PyFloat_FromDouble(x);
+    auto guard_pX = sg::make_scope_guard([&pX]() noexcept { Py_XDECREF(pX); });
+    auto pY = PyFloat_FromDouble(y);
+    auto guard_pY = sg::make_scope_guard([&pY]() noexcept { Py_XDECREF(pY); });
+    if (pX == NULL || pY == NULL) {
+        return -1.0;
+    }
+    PyObject* new_args[3] = {NULL, pX, pY};
+    auto pObj = PyObject_Vectorcall(pNew, new_args + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+    auto guard_pObj = sg::make_scope_guard([&pObj]() noexcept { Py_XDECREF(pObj); });
+    if (pObj == NULL) {
+        return -1.0;
+    }
+    PyObject* mod_args[2] = {NULL, pObj};
+    auto result = PyObject_VectorcallMethod(pModName, mod_args + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+    auto guard_result = sg::make_scope_guard([&result]() noexcept { Py_XDECREF(result); });
+    if (result == NULL) {
+        return -1.0;
+    }
+    return PyFloat_AsDouble(result);
+}
+
+template <typename F>
+double calls_per_second(long long n, F&& f) {
+    double checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < n; ++i) {
+        checksum += f(i);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (PyErr_Occurred()) {
+        PyErr_Print();
+    }
+    // 防止循环被优化掉
+    printf("  checksum %f\n", checksum);
+    return n / elapsed.count();
+}
+
+int main(int argc, char* argv[]) {
+    long long n = argc > 1 ? atoll(argv[1]) : 1000000;
+    try {
+        pyembed::Interpreter interp(pyembed::ConfigBuilder(argv[0]).venv("env/").module_path(std::filesystem::current_path()));
+        auto pModule = interp.handles().module("binary_vector");
+        if (pModule == NULL) {
+            PyErr_Print();
+            return 1;
+        }
+        // 关掉Vector析构时的打印,避免测的是stdout
+        PyRun_SimpleString("import sys, os; sys.stdout = open(os.devnull, 'w')");
+        {
+            // 调用点持有驻留的方法名,必须在回收解释器之前析构
+            VectorModCallSite mod_callsite(interp.handles());
+            if (import_binary_vector() < 0) {
+                PyErr_Print();
+                return 1;
+            }
+
+            auto naive = calls_per_second(n, [&](long long i) { return call_naive(pModule, 1, static_cast<double>(i & 0xff)); });
+            auto cached = calls_per_second(n, [&](long long i) { return mod_callsite(1, static_cast<double>(i & 0xff)); });
+            auto capi = calls_per_second(n, [&](long long i) {
+                auto v = vector_new(1, static_cast<float>(i & 0xff));
+                double result = vector_mod(v);
+                vector_del(v);
+                return result;
+            });
+            // 三种写法的差别远小于一次python调用的耗时,交替测几轮取最好的结果
+            auto pNew = mod_callsite.new_method();
+            auto pModName = mod_callsite.mod_name();
+            double manual = 0, guard = 0, pyref = 0;
+            for (int round = 0; round < 5; ++round) {
+                manual = std::max(manual, calls_per_second(n, [&](long long i) { return call_manual(pNew, pModName, 1, static_cast<double>(i & 0xff)); }));
+                guard = std::max(guard, calls_per_second(n, [&](long long i) { return call_guard(pNew, pModName, 1, static_cast<double>(i & 0xff)); }));
+                pyref = std::max(pyref, calls_per_second(n, [&](long long i) { return mod_callsite(1, static_cast<double>(i & 0xff)); }));
+            }
+            PyRun_SimpleString("sys.stdout.close(); sys.stdout = sys.__stdout__");
+            printf("naive:    %12.0f calls/s\n", naive);
+            printf("callsite: %12.0f calls/s (x%.2f)\n", cached, cached / naive);
+            printf("capi:     %12.0f calls/s (x%.2f)\n", capi, capi / naive);
+            printf("refcount handling on the callsite path:\n");
+            printf("  manual: %12.0f calls/s %8.1fns/call\n", manual, 1e9 / manual);
+            printf("  guard:  %12.0f calls/s %8.1fns/call\n", guard, 1e9 / guard);
+            printf("  pyref:  %12.0f calls/s %8.1fns/call\n", pyref, 1e9 / pyref);
+        }
+        return interp.finalize();
+    } catch (const pyembed::EmbedError& ex) {
+        fprintf(stderr, "%s", ex.what());
+        return 1;
+    }
+}
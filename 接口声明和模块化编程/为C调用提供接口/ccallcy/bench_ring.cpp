@@ -0,0 +1,111 @@
+/**
+ * 原生生产者通过`ShmRing`向cython批量传递`BINARY_VECTOR`的吞吐量
+ *
+ * 生产者不经过python,按批写入共享内存队列;python只调用一次`vector_ring.consume`,消费循环在`nogil`下运行.
+ * 对照`bench_call`中每条记录一次python调用的方式.
+ *
+ * + thread,生产者是同一进程中的线程
+ * + process,生产者是fork出的子进程,通过继承的`memfd`共享队列,在初始化解释器之前fork
+ *
+ * 用法: ./bench_ring [记录数,默认10000000] [thread|process]
+ */
+#include "pyembed.hpp"
+#include "scope_guard.hpp"
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "binary_vector.h"
+#include "shm_ring.hpp"
+
+constexpr std::size_t RING_CAPACITY = 1 << 16;  // 记录数,512KB
+constexpr std::size_t PRODUCER_BATCH = 1024;    // 生产者每次写入的记录数
+
+/**
+ * @brief 写入`n`条`{1, i & 0xff}`后关闭队列
+ */
+void produce(ShmRing<BINARY_VECTOR>& ring, long long n) {
+    std::vector<BINARY_VECTOR> batch(PRODUCER_BATCH);
+    for (long long i = 0; i < n;) {
+        std::size_t count = 0;
+        for (; count < PRODUCER_BATCH && i < n; ++count, ++i) {
+            batch[count] = BINARY_VECTOR{1, static_cast<float>(i & 0xff)};
+        }
+        ring.write(batch.data(), count);
+    }
+    ring.close();
+}
+
+int main(int argc, char* argv[]) {
+    long long n = argc > 1 ? atoll(argv[1]) : 10000000;
+    bool use_process = argc > 2 && strcmp(argv[2], "process") == 0;
+    try {
+        auto ring = ShmRing<BINARY_VECTOR>::create(RING_CAPACITY);
+        auto start = std::chrono::steady_clock::now();
+        pid_t producer_pid = -1;
+        // 提前返回或者抛出异常时生产者进程还在等待消费者,结束并回收它;正常结束时已经回收并置为-1
+        auto guard_producer = sg::make_scope_guard([&producer_pid]() noexcept {
+            if (producer_pid > 0) {
+                kill(producer_pid, SIGKILL);
+                waitpid(producer_pid, nullptr, 0);
+            }
+        });
+        if (use_process) {
+            producer_pid = fork();
+            if (producer_pid < 0) {
+                throw std::system_error(errno, std::generic_category(), "fork");
+            }
+            if (producer_pid == 0) {
+                produce(ring, n);
+                _exit(0);
+            }
+        }
+        pyembed::Interpreter interp(pyembed::ConfigBuilder(argv[0]).venv("env/").module_path(std::filesystem::current_path()));
+        auto consume = interp.handles().attr("vector_ring", "consume");
+        if (consume == NULL) {
+            PyErr_Print();
+            return 1;
+        }
+        std::thread producer_thread;
+        if (!use_process) {
+            producer_thread = std::thread([&ring, n] { produce(ring, n); });
+        }
+        // `consume`在nogil下等待和处理记录,这里不需要释放GIL
+        pyembed::PyRef stats(PyObject_CallFunction(consume, "i", ring.fd()));
+        if (!stats) {
+            PyErr_Print();
+            if (producer_thread.joinable()) {
+                // 没有消费者时生产者线程会一直等待队列空出位置,无法等它结束
+                fflush(stderr);
+                _exit(1);
+            }
+            return 1;
+        }
+        if (producer_thread.joinable()) {
+            producer_thread.join();
+        }
+        if (producer_pid > 0) {
+            waitpid(producer_pid, nullptr, 0);
+            producer_pid = -1;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        pyembed::PyRef text(PyObject_Str(stats.get()));
+        printf("%s\n", PyUnicode_AsUTF8(text.get()));
+        printf("%s: %12.0f records/s\n", use_process ? "process" : "thread", n / elapsed.count());
+        text = pyembed::PyRef();
+        stats = pyembed::PyRef();
+        return interp.finalize();
+    } catch (const pyembed::EmbedError& ex) {
+        fprintf(stderr, "%s", ex.what());
+        return 1;
+    } catch (const std::system_error& ex) {
+        fprintf(stderr, "%s", ex.what());
+        return 1;
+    }
+}
@@ -1 +1,8 @@
-g++ -I /Users/mac/micromamba/envs/py3.10/include/python3.10 -L/Users/mac/micromamba/envs/py3.10/lib -lpython3.10 -o ccallcy -std=c++20 main.cpp
\ No newline at end of file
+g++ -I /Users/mac/micromamba/envs/py3.10/include/python3.10 -I ../pyembed -I ../../为cython调用提供接口/wrapC -I ../../为cython调用提供接口/wrapC/vec/inc -L/Users/mac/micromamba/envs/py3.10/lib -lpython3.10 -o ccallcy -std=c++20 main.cpp ../pyembed/pyembed.cpp
+
+g++ -O2 -I /Users/mac/micromamba/envs/py3.10/include/python3.10 -I ../pyembed -I ../../为cython调用提供接口/wrapC -I ../../为cython调用提供接口/wrapC/vec/inc -L/Users/mac/micromamba/envs/py3.10/lib -lpython3.10 -o bench_call -std=c++20 bench_call.cpp ../pyembed/pyembed.cpp
+
+# 共享内存队列用到memfd和futex,下面两个只能在linux上编译
+cythonize -i -3 vector_ring.pyx
+
+g++ -O2 -I /Users/mac/micromamba/envs/py3.10/include/python3.10 -I ../pyembed -I ../../为cython调用提供接口/wrapC/vec/inc -L/Users/mac/micromamba/envs/py3.10/lib -lpython3.10 -o bench_ring -std=c++20 bench_ring.cpp ../pyembed/pyembed.cpp
@@ -0,0 +1,370 @@
+/**
+ * @file shm_ring.hpp
+ * @brief 共享内存上的单生产者单消费者环形队列,用于原生代码向cython批量传递定长记录
+ *
+ * 队列头和记录都在一块共享内存中(`memfd_create`或`shm_open`),生产者和消费者可以在同一进程的不同线程,
+ * 也可以在不同进程:`memfd`的fd通过fork继承或者unix socket传递,`shm_open`的用名字打开.
+ * 读写位置各占一个缓存行,正常情况下两边只做原子读写和`memcpy`,不进入内核;
+ * 一方需要等待时先自旋一小段时间,再在对应的序号上用futex睡眠,另一方只有看到等待标志时才调用`FUTEX_WAKE`.
+ * futex用的是非private的版本,在跨进程的共享映射上同样有效.
+ *
+ * 消费者用`acquire`直接拿到共享内存中一段连续记录的指针,处理完后`release`,记录不会被复制.
+ * 由`vector_ring.pyx`通过`cdef extern`使用,在`nogil`下批量处理`BINARY_VECTOR`.
+ *
+ * 只支持linux.
+ */
+#ifndef SHM_RING_HPP_
+#define SHM_RING_HPP_
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+namespace shm_ring_detail {
+
+constexpr std::uint32_t MAGIC = 0x52494e47;  // "RING"
+constexpr int SPIN = 256;                    // 睡眠前自旋检查的次数
+
+/**
+ * @brief 放在共享内存开头的队列头,记录紧跟其后
+ * @details 读写位置是只增不减的32位计数,回绕后差值仍然正确,因此容量最多为2^31.
+ */
+struct alignas(64) Header {
+    std::uint32_t magic;
+    std::uint32_t record_size;
+    std::uint32_t capacity;  // 记录数,2的幂
+    std::atomic<std::uint32_t> closed;
+    // 消费者写
+    alignas(64) std::atomic<std::uint32_t> head;
+    std::atomic<std::uint32_t> consumer_waiting;
+    std::atomic<std::uint32_t> consumer_seq;  // 消费者睡眠用的futex字
+    // 生产者写
+    alignas(64) std::atomic<std::uint32_t> tail;
+    std::atomic<std::uint32_t> producer_waiting;
+    std::atomic<std::uint32_t> producer_seq;  // 生产者睡眠用的futex字
+};
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free && sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+              "futex needs a plain 32-bit word");
+
+inline std::uint32_t* futex_word(std::atomic<std::uint32_t>& word) noexcept { return reinterpret_cast<std::uint32_t*>(&word); }
+
+inline void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected) noexcept {
+    // 字的值已经不是`expected`时立即返回EAGAIN,被信号打断时返回EINTR,调用方都会重新检查条件
+    syscall(SYS_futex, futex_word(word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+}
+
+inline void futex_wake(std::atomic<std::uint32_t>& word) noexcept {
+    syscall(SYS_futex, futex_word(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/**
+ * @brief 等待`ready()`成立
+ * @details 先自旋,不成立再登记等待标志并在`seq`上睡眠.登记后必须重新检查条件:
+ * 对方先更新位置再检查等待标志,两边都是顺序一致的原子操作,因此要么这里看到新位置,要么对方看到等待标志.
+ */
+template <typename Ready>
+void wait_until(Ready&& ready, std::atomic<std::uint32_t>& waiting, std::atomic<std::uint32_t>& seq) noexcept {
+    for (int i = 0; i < SPIN; ++i) {
+        if (ready()) {
+            return;
+        }
+        cpu_relax();
+    }
+    while (true) {
+        std::uint32_t observed = seq.load();
+        waiting.store(1);
+        if (ready()) {
+            waiting.store(0);
+            return;
+        }
+        futex_wait(seq, observed);
+    }
+}
+
+/**
+ * @brief 唤醒在`seq`上睡眠的一方,对方没有登记等待时不进入内核
+ */
+inline void notify(std::atomic<std::uint32_t>& waiting, std::atomic<std::uint32_t>& seq) noexcept {
+    if (waiting.load() != 0 && waiting.exchange(0) != 0) {
+        seq.fetch_add(1);
+        futex_wake(seq);
+    }
+}
+
+inline std::system_error os_error(const char* what) { return std::system_error(errno, std::generic_category(), what); }
+
+}  // namespace shm_ring_detail
+
+/**
+ * @brief 定长记录`T`的共享内存环形队列
+ * @details 一个`ShmRing`对象是一端的映射,只能由一个线程作为生产者或者消费者使用.
+ * 所有等待都不会超时,生产者结束时必须`close`,否则消费者会一直等待.
+ */
+template <typename T>
+class ShmRing {
+    static_assert(std::is_trivially_copyable_v<T>, "records are copied as raw bytes");
+    static_assert(alignof(T) <= alignof(shm_ring_detail::Header), "records follow the header");
+
+   public:
+    ShmRing() noexcept = default;
+
+    ShmRing(ShmRing&& other) noexcept
+        : header_(std::exchange(other.header_, nullptr)),
+          bytes_(std::exchange(other.bytes_, 0)),
+          fd_(std::exchange(other.fd_, -1)),
+          unlink_name_(std::move(other.unlink_name_)) {}
+
+    ShmRing& operator=(ShmRing&& other) noexcept {
+        if (this != &other) {
+            reset();
+            header_ = std::exchange(other.header_, nullptr);
+            bytes_ = std::exchange(other.bytes_, 0);
+            fd_ = std::exchange(other.fd_, -1);
+            unlink_name_ = std::move(other.unlink_name_);
+        }
+        return *this;
+    }
+
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    ~ShmRing() { reset(); }
+
+    /**
+     * @fn create
+     * @brief 在`memfd`上创建队列,用`fd()`交给另一端`attach`
+     * @param[capacity]  记录数,向上取整为2的幂
+     * @exception <std::system_error> { 创建或映射共享内存失败 }
+     */
+    static ShmRing create(std::size_t capacity) {
+        int fd = memfd_create("shm_ring", MFD_CLOEXEC);
+        if (fd < 0) {
+            throw shm_ring_detail::os_error("memfd_create");
+        }
+        return init(fd, capacity, std::string());
+    }
+
+    /**
+     * @fn create_named
+     * @brief 用`shm_open`创建名为`name`的队列,对象析构时删除这个名字
+     * @param[name]  共享内存名,以`/`开头,已经存在时失败
+     * @param[capacity]  记录数,向上取整为2的幂
+     * @exception <std::system_error> { 创建或映射共享内存失败 }
+     */
+    static ShmRing create_named(const char* name, std::size_t capacity) {
+        int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            throw shm_ring_detail::os_error("shm_open");
+        }
+        return init(fd, capacity, name);
+    }
+
+    /**
+     * @fn attach
+     * @brief 映射另一端创建的队列,`fd`会被复制,调用方仍然需要关闭自己的
+     * @exception <std::system_error> { 映射失败或者不是同样记录类型的队列 }
+     */
+    static ShmRing attach(int fd) {
+        int own = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (own < 0) {
+            throw shm_ring_detail::os_error("dup");
+        }
+        return map_existing(own);
+    }
+
+    /**
+     * @fn open_named
+     * @brief 打开`create_named`创建的队列
+     * @exception <std::system_error> { 打开,映射失败或者不是同样记录类型的队列 }
+     */
+    static ShmRing open_named(const char* name) {
+        int fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+        if (fd < 0) {
+            throw shm_ring_detail::os_error("shm_open");
+        }
+        return map_existing(fd);
+    }
+
+    int fd() const noexcept { return fd_; }
+    std::size_t capacity() const noexcept { return header_->capacity; }
+
+    /**
+     * @fn write
+     * @brief 生产者写入`n`条记录,空间不够时等待消费者读出
+     */
+    void write(const T* items, std::size_t n) noexcept {
+        auto& h = *header_;
+        const std::uint32_t capacity = h.capacity;
+        std::uint32_t tail = h.tail.load(std::memory_order_relaxed);
+        while (n > 0) {
+            std::uint32_t head = h.head.load(std::memory_order_acquire);
+            if (tail - head == capacity) {
+                shm_ring_detail::wait_until([&] { return tail - (head = h.head.load()) < capacity; }, h.producer_waiting,
+                                            h.producer_seq);
+            }
+            std::uint32_t pos = tail & (capacity - 1);
+            std::size_t count = std::min<std::size_t>({n, capacity - (tail - head), capacity - pos});
+            std::memcpy(records() + pos, items, count * sizeof(T));
+            tail += static_cast<std::uint32_t>(count);
+            items += count;
+            n -= count;
+            // 顺序一致的写,和`wait_until`中登记等待标志之后的检查配对
+            h.tail.store(tail);
+            shm_ring_detail::notify(h.consumer_waiting, h.consumer_seq);
+        }
+    }
+
+    /**
+     * @fn close
+     * @brief 生产者结束,消费者读完剩余的记录后`acquire`返回0
+     */
+    void close() noexcept {
+        header_->closed.store(1);
+        shm_ring_detail::notify(header_->consumer_waiting, header_->consumer_seq);
+    }
+
+    /**
+     * @fn acquire
+     * @brief 消费者等待可读的记录,取得其中连续的一段
+     * @param[first]  写入这一段第一条记录的地址,记录仍在共享内存中,`release`之前有效
+     * @param[max_count]  最多取得的记录数
+     * @return std::size_t 记录数,生产者已经`close`且队列为空时返回0
+     */
+    std::size_t acquire(const T** first, std::size_t max_count) noexcept {
+        auto& h = *header_;
+        const std::uint32_t capacity = h.capacity;
+        std::uint32_t head = h.head.load(std::memory_order_relaxed);
+        std::uint32_t tail = h.tail.load(std::memory_order_acquire);
+        if (tail == head) {
+            // 先读`closed`再读`tail`:生产者关闭前写入的记录一定能看到
+            shm_ring_detail::wait_until(
+                [&] {
+                    bool closed = h.closed.load() != 0;
+                    tail = h.tail.load();
+                    return closed || tail != head;
+                },
+                h.consumer_waiting, h.consumer_seq);
+            if (tail == head) {
+                return 0;
+            }
+        }
+        std::uint32_t pos = head & (capacity - 1);
+        *first = records() + pos;
+        return std::min<std::size_t>({max_count, tail - head, capacity - pos});
+    }
+
+    /**
+     * @fn release
+     * @brief 消费者处理完`acquire`取得的前`n`条记录,空出位置给生产者
+     */
+    void release(std::size_t n) noexcept {
+        auto& h = *header_;
+        h.head.store(h.head.load(std::memory_order_relaxed) + static_cast<std::uint32_t>(n));
+        shm_ring_detail::notify(h.producer_waiting, h.producer_seq);
+    }
+
+   private:
+    using Header = shm_ring_detail::Header;
+
+    static std::size_t bytes_for(std::size_t capacity) noexcept { return sizeof(Header) + capacity * sizeof(T); }
+
+    static ShmRing init(int fd, std::size_t capacity, std::string unlink_name) {
+        ShmRing ring;
+        ring.fd_ = fd;
+        ring.unlink_name_ = std::move(unlink_name);
+        capacity = std::bit_ceil(std::max<std::size_t>(capacity, 2));
+        if (capacity > (std::size_t(1) << 31)) {
+            errno = EINVAL;
+            throw shm_ring_detail::os_error("ShmRing capacity");
+        }
+        ring.bytes_ = bytes_for(capacity);
+        if (ftruncate(fd, static_cast<off_t>(ring.bytes_)) != 0) {
+            throw shm_ring_detail::os_error("ftruncate");
+        }
+        ring.map();
+        // 另一端在拿到fd之后才会映射,这里写入的队列头对它一定可见
+        auto header = new (ring.header_) Header{};
+        header->magic = shm_ring_detail::MAGIC;
+        header->record_size = sizeof(T);
+        header->capacity = static_cast<std::uint32_t>(capacity);
+        return ring;
+    }
+
+    static ShmRing map_existing(int fd) {
+        ShmRing ring;
+        ring.fd_ = fd;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            throw shm_ring_detail::os_error("fstat");
+        }
+        ring.bytes_ = static_cast<std::size_t>(st.st_size);
+        if (ring.bytes_ < sizeof(Header)) {
+            errno = EINVAL;
+            throw shm_ring_detail::os_error("ShmRing header");
+        }
+        ring.map();
+        auto& h = *ring.header_;
+        if (h.magic != shm_ring_detail::MAGIC ||
+            h.record_size != sizeof(T) || !std::has_single_bit(h.capacity) || ring.bytes_ < bytes_for(h.capacity)) {
+            errno = EINVAL;
+            throw shm_ring_detail::os_error("ShmRing header");
+        }
+        return ring;
+    }
+
+    void map() {
+        void* addr = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (addr == MAP_FAILED) {
+            throw shm_ring_detail::os_error("mmap");
+        }
+        header_ = static_cast<Header*>(addr);
+    }
+
+    T* records() const noexcept { return reinterpret_cast<T*>(header_ + 1); }
+
+    void reset() noexcept {
+        if (header_ != nullptr) {
+            munmap(header_, bytes_);
+            header_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        if (!unlink_name_.empty()) {
+            shm_unlink(unlink_name_.c_str());
+            unlink_name_.clear();
+        }
+    }
+
+    Header* header_ = nullptr;
+    std::size_t bytes_ = 0;
+    int fd_ = -1;
+    std::string unlink_name_;  // `create_named`创建的,析构时删除
+};
+
+#endif /* SHM_RING_HPP_ */
@@ -0,0 +1,70 @@
+/**
+ * @file vector_callsite.hpp
+ * @brief `binary_vector.Vector.new(x, y).mod()`的调用点缓存
+ *
+ * 构造时解析一次`Vector.new`并驻留方法名`mod`,之后每次调用只走`PyObject_Vectorcall`,
+ * 参数放在栈上的数组里,不再做属性查找也不再构造tuple.
+ */
+#ifndef VECTOR_CALLSITE_HPP_
+#define VECTOR_CALLSITE_HPP_
+
+#include "pyembed.hpp"
+
+class VectorModCallSite {
+   public:
+    /**
+     * @param[handles]  解释器的句柄缓存,`Vector.new`由它持有
+     * @exception <pyembed::EmbedError> { 找不到`Vector.new`或它不可调用 }
+     */
+    explicit VectorModCallSite(pyembed::HandleCache& handles) {
+        pNew_ = handles.attr("binary_vector", "Vector.new");
+        if (pNew_ == NULL || !PyCallable_Check(pNew_)) {
+            if (PyErr_Occurred()) {
+                PyErr_Print();  // 捕获错误,并打印
+            }
+            throw pyembed::EmbedError("Cannot find class new method Vector.new");
+        }
+        pModName_ = pyembed::PyRef(PyUnicode_InternFromString("mod"));
+        if (!pModName_) {
+            PyErr_Print();
+            throw pyembed::EmbedError("Cannot intern method name mod");
+        }
+    }
+    VectorModCallSite(const VectorModCallSite&) = delete;
+    VectorModCallSite& operator=(const VectorModCallSite&) = delete;
+
+    /**
+     * @brief 调用`Vector.new(x, y).mod()`,需要持有GIL
+     * @details 中间对象都由`PyRef`持有,任何一步失败提前返回时都会自动释放
+     * @return double 失败时返回-1.0并设置python异常
+     */
+    double operator()(double x, double y) const {
+        pyembed::PyRef pX(PyFloat_FromDouble(x));
+        pyembed::PyRef pY(PyFloat_FromDouble(y));
+        if (!pX || !pY) {
+            return -1.0;
+        }
+        // 第0位留空,配合PY_VECTORCALL_ARGUMENTS_OFFSET让被调用方可以原地放入self
+        PyObject* new_args[3] = {NULL, pX.get(), pY.get()};
+        pyembed::PyRef pObj(PyObject_Vectorcall(pNew_, new_args + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL));
+        if (!pObj) {
+            return -1.0;
+        }
+        // 同样在第0位留空,`PY_VECTORCALL_ARGUMENTS_OFFSET`允许被调用方临时改写`args[-1]`
+        PyObject* mod_args[2] = {NULL, pObj.get()};
+        pyembed::PyRef result(PyObject_VectorcallMethod(pModName_.get(), mod_args + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL));
+        if (!result) {
+            return -1.0;
+        }
+        return PyFloat_AsDouble(result.get());
+    }
+
+    PyObject* new_method() const noexcept { return pNew_; }
+    PyObject* mod_name() const noexcept { return pModName_.get(); }
+
+   private:
+    PyObject* pNew_ = NULL;      // 借用引用,由HandleCache持有
+    pyembed::PyRef pModName_;    // 驻留的方法名
+};
+
+#endif /* VECTOR_CALLSITE_HPP_ */
@@ -0,0 +1,95 @@
+# distutils: language=c++
+# distutils: extra_compile_args=-std=c++20
+# distutils: include_dirs=../../为cython调用提供接口/wrapC/vec/inc
+# distutils: library_dirs=../../为cython调用提供接口/wrapC/vec/lib
+# distutils: libraries=vector
+"""从共享内存环形队列中批量消费`BINARY_VECTOR`.
+
+C++宿主或者其他进程中的原生代码用`shm_ring.hpp`中的`ShmRing<BINARY_VECTOR>`写入记录,
+python只调用一次`consume`,之后整个消费循环都在`nogil`下进行,每条记录不再经过python的C API.
+"""
+from libc.stddef cimport size_t
+
+
+# `binary_vector.h`是C的头文件,没有`extern "C"`,按C++编译时需要自己包一层
+cdef extern from *:
+    """
+    extern "C" {
+    #include "binary_vector.h"
+    }
+    """
+
+
+cdef extern from "binary_vector.h" nogil:
+
+    cdef struct BINARY_VECTOR:
+        float x
+        float y
+
+    float VEC_mod(BINARY_VECTOR*)
+
+
+cdef extern from "shm_ring.hpp" nogil:
+
+    cdef cppclass ShmRing[T]:
+        ShmRing()
+        size_t acquire(const T** first, size_t max_count)
+        void release(size_t n)
+
+        @staticmethod
+        ShmRing[T] attach(int fd) except +
+
+        @staticmethod
+        ShmRing[T] open_named(const char* name) except +
+
+
+cdef struct RingStats:
+    size_t records
+    size_t batches
+    double mod_sum
+    float mod_max
+
+
+cdef void consume_batches(ShmRing[BINARY_VECTOR]& ring, size_t max_batch, RingStats* stats) noexcept nogil:
+    """读到生产者关闭为止,每次处理一段连续的记录,记录直接在共享内存中读取."""
+    cdef const BINARY_VECTOR* batch
+    cdef size_t n, i
+    cdef float mod
+    while True:
+        n = ring.acquire(&batch, max_batch)
+        if n == 0:
+            return
+        for i in range(n):
+            mod = VEC_mod(<BINARY_VECTOR*>&batch[i])
+            stats.mod_sum += mod
+            if mod > stats.mod_max:
+                stats.mod_max = mod
+        ring.release(n)
+        stats.records += n
+        stats.batches += 1
+
+
+def consume(fd=None, name=None, Py_ssize_t max_batch=4096):
+    """消费队列中的向量直到生产者关闭,返回统计结果.
+
+    Args:
+        fd (int): `ShmRing::create`创建的队列的fd,和`name`二选一
+        name (str): `ShmRing::create_named`创建的队列名
+        max_batch (int): 每批最多处理的记录数
+
+    Returns:
+        dict: `records`记录数,`batches`批数,`mod_sum`模的和,`mod_max`最大的模
+    """
+    cdef ShmRing[BINARY_VECTOR] ring
+    cdef RingStats stats = RingStats(0, 0, 0.0, 0.0)
+    if max_batch <= 0:
+        raise ValueError("max_batch must be positive")
+    if (fd is None) == (name is None):
+        raise ValueError("exactly one of fd and name is required")
+    if fd is not None:
+        ring = ShmRing[BINARY_VECTOR].attach(fd)
+    else:
+        ring = ShmRing[BINARY_VECTOR].open_named(name.encode())
+    with nogil:
+        consume_batches(ring, <size_t>max_batch, &stats)
+    return {"records": stats.records, "batches": stats.batches, "mod_sum": stats.mod_sum, "mod_max": stats.mod_max}
@@ -3,4 +3,12 @@ cython -3 -+  emb.pyx
 
 cython -3 -+  embapi.pyx
 
-g++ -I /Users/mac/micromamba/envs/py3.10/include/python3.10 -I /usr/local/include -L/Users/mac/micromamba/envs/py3.10/lib -lpython3.10 -o cythonembeddingc -std=c++20 main.cpp emb.cpp
\ No newline at end of file
+g++ -I /Users/mac/micromamba/envs/py3.10/include/python3.10 -I ../pyembed -I /usr/local/include -L/Users/mac/micromamba/envs/py3.10/lib -lpython3.10 -o cythonembeddingc -std=c++20 main.cpp emb.cpp ../pyembed/pyembed.cpp
+
+# 热重载用的新版本,修改emb.pyx后重新cython再编译,放在程序的工作目录下,通过`POST /admin/reload/<版本>`加载.
+# macos
+g++ -bundle -undefined dynamic_lookup -I /Users/mac/micromamba/envs/py3.10/include/python3.10 -I /usr/local/include -o emb.v2.so -std=c++20 emb.cpp
+# linux上需要加`-Wl,-Bsymbolic`,让新版本中的函数调用绑定到自己的定义,而不是可执行文件中静态链接的那份.
+# `-Bsymbolic`管不到`STB_GNU_UNIQUE`符号,每个版本自己的注册表和输出流因此放在头文件的匿名命名空间中,
+# 改动这些头文件后可以用`readelf -sW emb.v2.so | grep UNIQUE`确认其中没有它们
+# g++ -shared -fPIC -Wl,-Bsymbolic $(python3-config --includes) -I /usr/local/include -o emb.v2.so -std=c++20 emb.cpp
@@ -2398,6 +2398,7 @@ namespace crow
         NOT_FOUND                     = 404,
         METHOD_NOT_ALLOWED            = 405,
         PROXY_AUTHENTICATION_REQUIRED = 407,
+        REQUEST_TIMEOUT               = 408, // Local change: used by /submit when a script exceeds its deadline
         CONFLICT                      = 409,
         GONE                          = 410,
         PAYLOAD_TOO_LARGE             = 413,
@@ -2948,6 +2949,13 @@ namespace crow
         bool skip_body = false;            ///< Whether this is a response to a HEAD request.
         bool manual_length_header = false; ///< Whether Crow should automatically add a "Content-Length" header.
 
+        /// Local change: when set, the body is produced by calling this repeatedly and sent with chunked transfer encoding.
+
+        ///
+        /// Each call appends the next piece of the body to its argument and returns false once the body is complete.
+        /// It runs on the connection's thread and may block there, like the synchronous writes of large bodies.
+        std::function<bool(std::string&)> body_source;
+
         /// Set the value of an existing header in the response.
         void set_header(std::string key, std::string value)
         {
@@ -3015,6 +3023,7 @@ namespace crow
             headers = std::move(r.headers);
             completed_ = r.completed_;
             file_info = std::move(r.file_info);
+            body_source = std::move(r.body_source); // Local change
             return *this;
         }
 
@@ -3031,6 +3040,7 @@ namespace crow
             headers.clear();
             completed_ = false;
             file_info = static_file_info{};
+            body_source = nullptr; // Local change
         }
 
         /// Return a "Temporary Redirect" response.
@@ -11437,9 +11447,19 @@ namespace crow
                 res.set_header("location", location);
             }
 
+            // Local change: streamed bodies use chunked transfer encoding instead of Content-Length
+            if (res.body_source)
+            {
+                res.set_header("Transfer-Encoding", "chunked");
+            }
+
             prepare_buffers();
 
-            if (res.is_static_type())
+            if (res.body_source)
+            {
+                do_write_stream();
+            }
+            else if (res.is_static_type())
             {
                 do_write_static();
             }
@@ -11489,6 +11509,7 @@ namespace crow
               {status::NOT_FOUND, "HTTP/1.1 404 Not Found\r\n"},
               {status::METHOD_NOT_ALLOWED, "HTTP/1.1 405 Method Not Allowed\r\n"},
               {status::PROXY_AUTHENTICATION_REQUIRED, "HTTP/1.1 407 Proxy Authentication Required\r\n"},
+              {status::REQUEST_TIMEOUT, "HTTP/1.1 408 Request Timeout\r\n"}, // Local change
               {status::CONFLICT, "HTTP/1.1 409 Conflict\r\n"},
               {status::GONE, "HTTP/1.1 410 Gone\r\n"},
               {status::PAYLOAD_TOO_LARGE, "HTTP/1.1 413 Payload Too Large\r\n"},
@@ -11530,7 +11551,7 @@ namespace crow
                 buffers_.emplace_back(crlf.data(), crlf.size());
             }
 
-            if (!res.manual_length_header && !res.headers.count("content-length"))
+            if (!res.manual_length_header && !res.body_source && !res.headers.count("content-length"))
             {
                 content_length_ = std::to_string(res.body.size());
                 static std::string content_length_tag = "Content-Length: ";
@@ -11596,6 +11617,53 @@ namespace crow
             parser_.clear();
         }
 
+        // Local change: write a response whose body comes from response::body_source
+        void do_write_stream()
+        {
+            is_writing = true;
+            boost::system::error_code ec;
+            boost::asio::write(adaptor_.socket(), buffers_, ec); // Write the response start / headers
+            std::string chunk;
+            bool more = true;
+            while (!ec && more)
+            {
+                chunk.clear();
+                more = res.body_source(chunk);
+                if (chunk.empty())
+                {
+                    continue;
+                }
+                char size_line[24];
+                int size_len = snprintf(size_line, sizeof(size_line), "%zx\r\n", chunk.size());
+                std::array<asio::const_buffer, 3> parts{
+                  boost::asio::buffer(size_line, size_len), boost::asio::buffer(chunk), boost::asio::buffer(crlf)};
+                boost::asio::write(adaptor_.socket(), parts, ec);
+            }
+            if (!ec)
+            {
+                static const std::string last_chunk = "0\r\n\r\n";
+                boost::asio::write(adaptor_.socket(), boost::asio::buffer(last_chunk), ec);
+            }
+            if (ec)
+            {
+                CROW_LOG_ERROR << ec << " - happened while streaming the response";
+                close_connection_ = true;
+            }
+            is_writing = false;
+            if (close_connection_)
+            {
+                adaptor_.shutdown_readwrite();
+                adaptor_.close();
+                CROW_LOG_DEBUG << this << " from write (body_source)";
+                check_destroy();
+            }
+
+            res.end();
+            res.clear();
+            buffers_.clear();
+            parser_.clear();
+        }
+
         void do_write_general()
         {
             if (res.body.length() < res_stream_threshold_)
@@ -11856,8 +11924,8 @@ namespace crow
     class Server
     {
     public:
-        Server(Handler* handler, std::string bindaddr, uint16_t port, std::string server_name = std::string("Crow/") + VERSION, std::tuple<Middlewares...>* middlewares = nullptr, uint16_t concurrency = 1, uint8_t timeout = 5, typename Adaptor::context* adaptor_ctx = nullptr):
-          acceptor_(io_service_, tcp::endpoint(boost::asio::ip::address::from_string(bindaddr), port)),
+        Server(Handler* handler, std::string bindaddr, uint16_t port, std::string server_name = std::string("Crow/") + VERSION, std::tuple<Middlewares...>* middlewares = nullptr, uint16_t concurrency = 1, uint8_t timeout = 5, typename Adaptor::context* adaptor_ctx = nullptr, bool reuse_port = false):
+          acceptor_(io_service_),
           signals_(io_service_),
           tick_timer_(io_service_),
           handler_(handler),
@@ -11869,7 +11937,18 @@ namespace crow
           task_queue_length_pool_(concurrency_ - 1),
           middlewares_(middlewares),
           adaptor_ctx_(adaptor_ctx)
-        {}
+        {
+            // Local change: optionally set SO_REUSEPORT before bind so that several processes can listen on one port
+            tcp::endpoint endpoint(boost::asio::ip::address::from_string(bindaddr), port);
+            acceptor_.open(endpoint.protocol());
+            acceptor_.set_option(tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+            if (reuse_port)
+                acceptor_.set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+#endif
+            acceptor_.bind(endpoint);
+            acceptor_.listen();
+        }
 
         void set_tick_function(std::chrono::milliseconds d, std::function<void()> f)
         {
@@ -12219,6 +12298,13 @@ namespace crow
             return port_;
         }
 
+        /// Set SO_REUSEPORT on the listening socket so that several processes can serve the same port (local change)
+        self_t& reuse_port(bool on = true)
+        {
+            reuse_port_ = on;
+            return *this;
+        }
+
 
         /// Set the connection timeout in seconds (default is 5)
         self_t& timeout(std::uint8_t timeout)
@@ -12376,7 +12462,7 @@ namespace crow
 #ifdef CROW_ENABLE_SSL
             if (ssl_used_)
             {
-                ssl_server_ = std::move(std::unique_ptr<ssl_server_t>(new ssl_server_t(this, bindaddr_, port_, server_name_, &middlewares_, concurrency_, timeout_, &ssl_context_)));
+                ssl_server_ = std::move(std::unique_ptr<ssl_server_t>(new ssl_server_t(this, bindaddr_, port_, server_name_, &middlewares_, concurrency_, timeout_, &ssl_context_, reuse_port_)));
                 ssl_server_->set_tick_function(tick_interval_, tick_function_);
                 ssl_server_->signal_clear();
                 for (auto snum : signals_)
@@ -12389,7 +12475,7 @@ namespace crow
             else
 #endif
             {
-                server_ = std::move(std::unique_ptr<server_t>(new server_t(this, bindaddr_, port_, server_name_, &middlewares_, concurrency_, timeout_, nullptr)));
+                server_ = std::move(std::unique_ptr<server_t>(new server_t(this, bindaddr_, port_, server_name_, &middlewares_, concurrency_, timeout_, nullptr, reuse_port_)));
                 server_->set_tick_function(tick_interval_, tick_function_);
                 server_->signal_clear();
                 for (auto snum : signals_)
@@ -12553,6 +12639,7 @@ namespace crow
         std::uint8_t timeout_{5};
         uint16_t port_ = 80;
         uint16_t concurrency_ = 2;
+        bool reuse_port_ = false;
         bool validated_ = false;
         std::string server_name_ = std::string("Crow/") + VERSION;
         std::string bindaddr_ = "0.0.0.0";
@@ -1,4 +1,4 @@
-/* Generated by Cython 3.0.2 */
+/* Generated by Cython 3.3.0 */
 
 #ifndef __PYX_HAVE__emb
 #define __PYX_HAVE__emb
@@ -26,15 +26,13 @@
 
 __PYX_EXTERN_C int get_numargsc(void);
 __PYX_EXTERN_C void set_numargsc(int);
+__PYX_EXTERN_C Py_ssize_t run_kernel(char const *, char const *, Py_ssize_t, char *, Py_ssize_t);
 
 #endif /* !__PYX_HAVE_API__emb */
 
 /* WARNING: the interface of the module init function changed in CPython 3.5. */
 /* It now returns a PyModuleDef instance instead of a PyModule instance. */
 
-#if PY_MAJOR_VERSION < 3
-PyMODINIT_FUNC initemb(void);
-#else
 /* WARNING: Use PyImport_AppendInittab("emb", PyInit_emb) instead of calling PyInit_emb directly from Python 3.5 */
 PyMODINIT_FUNC PyInit_emb(void);
 
@@ -51,6 +49,5 @@ static PyObject* __PYX_WARN_IF_PyInit_emb_INIT_CALLED(PyObject* res) {
 }
 #define PyInit_emb() __PYX_WARN_IF_PyInit_emb_INIT_CALLED(PyInit_emb())
 #endif
-#endif
 
 #endif /* !__PYX_HAVE__emb */
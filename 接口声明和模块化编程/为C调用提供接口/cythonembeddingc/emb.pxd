@@ -1,3 +1,52 @@
+from libc.stdint cimport int64_t
+from libcpp.string cimport string
+from libcpp.vector cimport vector
+
 cdef int numargs
 cdef public int get_numargsc()
-cdef public void set_numargsc(int i)
\ No newline at end of file
+cdef public void set_numargsc(int i)
+
+cdef public Py_ssize_t run_kernel(const char* name, const char* data, Py_ssize_t nbytes, char* out, Py_ssize_t out_nbytes) except -2
+
+cdef extern from "result_stream.hpp" nogil:
+    cdef cppclass ResultStream:
+        int write(const char* data, size_t len) noexcept
+
+    ResultStream* current_result_stream() noexcept
+    ResultStream* exchange_result_stream(ResultStream* stream) noexcept
+
+    enum:
+        WRITE_OK "ResultStream::WRITE_OK"
+        WRITE_CLOSED "ResultStream::WRITE_CLOSED"
+        WRITE_TIMEOUT "ResultStream::WRITE_TIMEOUT"
+
+
+# 其他cython模块`cimport emb`后可以用`native_registry().add`登记自己的函数,登记完后调用`publish`
+cdef extern from "native_registry.hpp" nogil:
+    # 数组到数组:读取`n`个输入写入输出,返回写入的个数.输出的容量为`n`,标量结果的只写入1个
+    ctypedef Py_ssize_t (*native_array_f64)(const double* x, Py_ssize_t n, double* out) noexcept nogil
+    ctypedef double (*native_f64_f64)(double x) noexcept nogil
+    ctypedef int64_t (*native_i64_i64)(int64_t x) noexcept nogil
+
+    cdef cppclass NativeRegistry:
+        void add(const char* name, native_array_f64 fn) except +
+        void add(const char* name, native_f64_f64 fn) except +
+        void add(const char* name, native_i64_i64 fn) except +
+        # 参数超出`[min_arg, max_arg]`时宿主直接拒绝,不调用函数
+        void add(const char* name, native_i64_i64 fn, int64_t min_arg, int64_t max_arg) except +
+        void publish() except +
+        native_array_f64 find_array_f64(const char* name) noexcept
+        vector[string] names() except +
+
+    NativeRegistry& native_registry() noexcept
+
+# 宿主通过模块属性`_C_API`取得的函数表,热重载后每个版本各有一份
+cdef extern from "emb_api.h":
+    const char* EMB_API_CAPSULE
+
+    ctypedef struct EmbApi:
+        int (*get_numargsc)() noexcept
+        void (*set_numargsc)(int) noexcept
+        Py_ssize_t (*run_kernel)(const char*, const char*, Py_ssize_t, char*, Py_ssize_t) noexcept
+        void* (*native_registry)() noexcept nogil
+        void* (*bind_result_stream)(void* stream) noexcept nogil
@@ -1,4 +1,12 @@
 # distutils: language = c++
+cimport cython
+from cpython.buffer cimport PyBUF_READ, PyBUF_WRITE
+from cpython.memoryview cimport PyMemoryView_FromMemory
+from cpython.pycapsule cimport PyCapsule_New
+from libc.math cimport exp, sqrt
+from libc.stdint cimport int64_t, uint64_t
+import json
+
 cdef int numargs = 0
 
 cdef int get_numargsc():
@@ -15,4 +23,148 @@ cdef void set_numargsc(int i):
 
 def set_numargs(int i):
     cdef int _i = i
-    set_numargsc(_i)
\ No newline at end of file
+    set_numargsc(_i)
+
+
+def sse_frame(data):
+    """把一条结果编码为Server-Sent Events的`data`事件.
+
+    多行的结果每行各加一个`data: `前缀,客户端收到后会重新用换行拼接.
+    """
+    if isinstance(data, str):
+        data = data.encode()
+    data = data.replace(b"\r\n", b"\n").replace(b"\r", b"\n")
+    return b"".join([b"data: " + line + b"\n" for line in data.split(b"\n")]) + b"\n"
+
+
+def emit(obj):
+    """向当前请求的结果流写入一条结果,客户端会立即收到.
+
+    `str`和`bytes`按原样发送,其他对象先序列化为json.
+    缓冲满时释放GIL等待客户端读取.
+
+    Returns:
+        bool: 写入了结果流时为`True`;不是通过`/submit/stream`执行时没有结果流,返回`False`
+
+    Raises:
+        ConnectionAbortedError: 客户端已断开
+        TimeoutError: 等待客户端读取时超过了脚本的截止时间
+    """
+    cdef ResultStream* stream = current_result_stream()
+    if stream == NULL:
+        return False
+    if not isinstance(obj, (str, bytes, bytearray, memoryview)):
+        obj = json.dumps(obj)
+    elif not isinstance(obj, (str, bytes)):
+        obj = bytes(obj)
+    frame = sse_frame(obj)
+    cdef const char* data = frame
+    cdef size_t length = len(frame)
+    cdef int status
+    with nogil:
+        status = stream.write(data, length)
+    if status == WRITE_CLOSED:
+        raise ConnectionAbortedError("client closed the result stream")
+    if status == WRITE_TIMEOUT:
+        raise TimeoutError("result stream is full and the script deadline passed")
+    return True
+
+
+cdef void* emb_native_registry() noexcept nogil:
+    """本模块登记函数用的注册表,热重载后每个版本各有一个."""
+    return &native_registry()
+
+
+cdef void* emb_bind_result_stream(void* stream) noexcept nogil:
+    """把`stream`设为当前线程`emit`的输出流,返回原来的."""
+    return exchange_result_stream(<ResultStream*>stream)
+
+
+def native_names():
+    """已注册的`nogil`函数名,包括`/kernel`可以调用的数值核函数."""
+    return [name.decode() for name in native_registry().names()]
+
+
+@cython.boundscheck(False)
+cdef public Py_ssize_t run_kernel(const char* name, const char* data, Py_ssize_t nbytes, char* out, Py_ssize_t out_nbytes) except -2:
+    """C++调用,在`data`上执行名为`name`的`array_f64`签名的函数,结果写入`out`.需要持有GIL,核函数执行期间释放.
+
+    `data`和`out`都是原生字节序的`double`数组,通过buffer协议直接映射为memoryview,不复制也不解析.
+    `out_nbytes`不能小于`nbytes`.
+
+    Returns:
+        Py_ssize_t: 写入`out`的字节数;没有这个核函数时返回-1;出错时返回-2并设置python异常
+    """
+    cdef native_array_f64 kernel = native_registry().find_array_f64(name)
+    if kernel == NULL:
+        return -1
+    if out_nbytes < nbytes:
+        raise ValueError("output buffer is smaller than the input")
+    # 字节数不是8的倍数时`cast`会抛出TypeError
+    cdef const double[::1] x = PyMemoryView_FromMemory(<char*>data, nbytes, PyBUF_READ).cast("d")
+    cdef double[::1] y = PyMemoryView_FromMemory(out, out_nbytes, PyBUF_WRITE).cast("d")
+    cdef Py_ssize_t n = x.shape[0]
+    cdef Py_ssize_t written
+    if n == 0:
+        raise ValueError("empty input")
+    with nogil:
+        written = kernel(&x[0], n, &y[0])
+    return written * <Py_ssize_t>sizeof(double)
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef Py_ssize_t l2norm_kernel(const double* x, Py_ssize_t n, double* out) noexcept nogil:
+    cdef double total = 0
+    cdef Py_ssize_t i
+    for i in range(n):
+        total += x[i] * x[i]
+    out[0] = sqrt(total)
+    return 1
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+@cython.cdivision(True)
+cdef Py_ssize_t normalize_kernel(const double* x, Py_ssize_t n, double* out) noexcept nogil:
+    cdef double norm
+    cdef Py_ssize_t i
+    l2norm_kernel(x, n, &norm)
+    for i in range(n):
+        out[i] = x[i] / norm
+    return n
+
+
+cdef double sigmoid(double x) noexcept nogil:
+    return 1.0 / (1.0 + exp(-x))
+
+
+cdef enum:
+    FIB_MAX_N = 92  # fib(92)是int64能表示的最大的斐波那契数
+
+
+cdef int64_t fib(int64_t n) noexcept nogil:
+    """第`n`个斐波那契数,`n`由注册表限定在`[0, FIB_MAX_N]`内."""
+    cdef uint64_t a = 0
+    cdef uint64_t b = 1
+    cdef int64_t i
+    for i in range(n):
+        a, b = b, a + b
+    return <int64_t>a
+
+
+native_registry().add(b"l2norm", l2norm_kernel)
+native_registry().add(b"normalize", normalize_kernel)
+native_registry().add(b"sigmoid", sigmoid)
+native_registry().add(b"fib", fib, 0, FIB_MAX_N)
+native_registry().publish()
+
+
+cdef EmbApi emb_api
+# `get_numargsc`等的异常声明和C的函数指针类型不同,这里显式转换,宿主调用后自行检查python异常
+emb_api.get_numargsc = <int (*)() noexcept>get_numargsc
+emb_api.set_numargsc = <void (*)(int) noexcept>set_numargsc
+emb_api.run_kernel = <Py_ssize_t (*)(const char*, const char*, Py_ssize_t, char*, Py_ssize_t) noexcept>run_kernel
+emb_api.native_registry = emb_native_registry
+emb_api.bind_result_stream = emb_bind_result_stream
+_C_API = PyCapsule_New(&emb_api, EMB_API_CAPSULE, NULL)
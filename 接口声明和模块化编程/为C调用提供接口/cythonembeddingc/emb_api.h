@@ -0,0 +1,27 @@
+/**
+ * @file emb_api.h
+ * @brief `emb`导出给宿主的函数表
+ *
+ * 函数表放在模块属性`_C_API`(名为`EMB_API_CAPSULE`的PyCapsule)中,宿主从模块对象取得,
+ * 不依赖链接时的符号,热重载后从新模块对象取得的就是新版本的函数.
+ */
+#ifndef EMB_API_H_
+#define EMB_API_H_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#define EMB_API_CAPSULE "emb._C_API"
+
+typedef struct EmbApi {
+    int (*get_numargsc)(void);
+    void (*set_numargsc)(int);
+    /* 见`emb.pyx`中的`run_kernel`,需要持有GIL */
+    Py_ssize_t (*run_kernel)(const char* name, const char* data, Py_ssize_t nbytes, char* out, Py_ssize_t out_nbytes);
+    /* 本版本的`NativeRegistry*` */
+    void* (*native_registry)(void);
+    /* 设置当前线程`emb.emit`的输出流`ResultStream*`,返回原来的 */
+    void* (*bind_result_stream)(void* stream);
+} EmbApi;
+
+#endif /* EMB_API_H_ */
@@ -0,0 +1,145 @@
+/**
+ * @file hot_reload.hpp
+ * @brief 不重启宿主,加载新编译的`emb`并切换过去
+ *
+ * 新版本编译为带版本号的`emb.<版本>.so`,和旧版本并存.加载时用`importlib`按文件路径导入,
+ * 文件不同dlopen得到的就是独立的一份代码和静态变量,因此同名模块可以加载多个版本.
+ * 每个版本自己的静态变量(注册表,输出流)必须是内部链接的,否则会被动态加载器合并,见`native_registry.hpp`.
+ * 宿主对`emb`的所有调用都经过模块属性`_C_API`中的`EmbApi`函数表,切换版本就是原子地替换`EmbModules`中的当前版本;
+ * 请求开始时取得当前版本的`shared_ptr`,整个请求都使用这个版本,切换后等旧版本的引用全部释放即完成排空.
+ *
+ * 最初通过inittab注册的`PyInit_emb`是第一个版本.
+ * 和CPython一样,旧版本不会dlclose,模块对象也一直保留:python中可能还有对象引用着旧版本的代码.
+ */
+#ifndef HOT_RELOAD_HPP_
+#define HOT_RELOAD_HPP_
+
+#include "pyembed.hpp"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include "emb_api.h"
+#include "native_registry.hpp"
+
+/**
+ * @brief 加载了的一个`emb`版本
+ */
+struct EmbVersion {
+    std::string version;
+    EmbApi api;
+    PyObject* module = nullptr;  // 强引用,不释放
+
+    NativeRegistry& registry() const noexcept { return *static_cast<NativeRegistry*>(api.native_registry()); }
+};
+
+/**
+ * @brief 当前使用的`emb`版本
+ */
+class EmbModules {
+   public:
+    /**
+     * @fn current
+     * @brief 当前版本,请求开始时取得并持有到请求结束
+     */
+    std::shared_ptr<const EmbVersion> current() const noexcept { return current_.load(); }
+
+    /**
+     * @fn swap_and_drain
+     * @brief 切换到`next`,然后等待旧版本上进行中的调用结束,不能在持有GIL时调用
+     * @param[next]  新版本
+     * @param[timeout]  最多等待的时间
+     * @return bool 旧版本是否已经排空,超时返回false,此时切换已经完成,旧版本上的调用会继续执行到结束
+     */
+    bool swap_and_drain(std::shared_ptr<const EmbVersion> next, std::chrono::milliseconds timeout) {
+        auto old = current_.exchange(std::move(next));
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        // 切换后不会再有新的持有者,引用计数只减不增
+        while (old && old.use_count() > 1) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+   private:
+    std::atomic<std::shared_ptr<const EmbVersion>> current_;
+};
+
+namespace detail {
+inline pyembed::EmbedError load_error(const std::string& what) {
+    std::string msg = what;
+    if (PyErr_Occurred()) {
+        PyObject *type, *value, *traceback;
+        PyErr_Fetch(&type, &value, &traceback);
+        pyembed::PyRef text(value ? PyObject_Str(value) : NULL);
+        if (text && PyUnicode_Check(text.get())) {
+            msg += std::string(": ") + PyUnicode_AsUTF8(text.get());
+        }
+        Py_XDECREF(type);
+        Py_XDECREF(value);
+        Py_XDECREF(traceback);
+        PyErr_Clear();
+    }
+    return pyembed::EmbedError(msg);
+}
+}  // namespace detail
+
+/**
+ * @fn std::shared_ptr<EmbVersion> emb_version_from_module(PyObject*, const std::string&)
+ * @brief 从已经导入的`emb`模块对象取得它导出的函数表,需要持有GIL
+ * @param[module]  模块对象,借用引用,成功时`EmbVersion`会持有一个强引用
+ * @param[version]  版本号
+ * @exception <pyembed::EmbedError> { 模块没有`_C_API`或者类型不对 }
+ */
+inline std::shared_ptr<EmbVersion> emb_version_from_module(PyObject* module, const std::string& version) {
+    pyembed::PyRef capsule(PyObject_GetAttrString(module, "_C_API"));
+    void* api = capsule ? PyCapsule_GetPointer(capsule.get(), EMB_API_CAPSULE) : NULL;
+    if (api == NULL) {
+        throw detail::load_error("emb " + version + " has no " EMB_API_CAPSULE);
+    }
+    auto loaded = std::make_shared<EmbVersion>();
+    loaded->version = version;
+    // 函数表是模块中的静态变量,模块不会被卸载,这里复制一份省去每次调用的间接访问
+    loaded->api = *static_cast<EmbApi*>(api);
+    Py_INCREF(module);
+    loaded->module = module;
+    return loaded;
+}
+
+/**
+ * @fn std::shared_ptr<EmbVersion> load_emb_version(const std::filesystem::path&, const std::string&)
+ * @brief 导入`path`处的`emb`模块并取得它导出的函数表,需要持有GIL
+ * @details 模块的初始化代码会执行,其中登记的`nogil`函数发布到新版本自己的注册表中.
+ * 不修改`sys.modules`,由调用方决定何时让python代码看到新版本.
+ * @param[path]  `.so`的路径,同一个文件只能加载一次
+ * @param[version]  版本号
+ * @exception <pyembed::EmbedError> { 导入失败或者模块没有导出函数表 }
+ */
+inline std::shared_ptr<EmbVersion> load_emb_version(const std::filesystem::path& path, const std::string& version) {
+    auto fail = [&path](const char* step) { return detail::load_error("cannot load " + path.string() + ": " + step); };
+    pyembed::PyRef util(PyImport_ImportModule("importlib.util"));
+    if (!util) {
+        throw fail("importlib.util");
+    }
+    pyembed::PyRef spec(PyObject_CallMethod(util.get(), "spec_from_file_location", "ss", "emb", path.c_str()));
+    if (!spec || spec.get() == Py_None) {
+        throw fail("spec_from_file_location");
+    }
+    pyembed::PyRef module(PyObject_CallMethod(util.get(), "module_from_spec", "O", spec.get()));
+    if (!module) {
+        throw fail("module_from_spec");
+    }
+    pyembed::PyRef loader(PyObject_GetAttrString(spec.get(), "loader"));
+    pyembed::PyRef executed(loader ? PyObject_CallMethod(loader.get(), "exec_module", "O", module.get()) : NULL);
+    if (!executed) {
+        throw fail("exec_module");
+    }
+    return emb_version_from_module(module.get(), version);
+}
+
+#endif /* HOT_RELOAD_HPP_ */
@@ -1,11 +1,34 @@
-#define PY_SSIZE_T_CLEAN
-#include <Python.h>
+#include "pyembed.hpp"
+#include <errno.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <cstdlib>
 #include <exception>
 #include <filesystem>
-#include <map>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <string>
+#include <thread>
+#include <vector>
 #include "crow_all.h"
 #include "scope_guard.hpp"
+#include "metrics.hpp"
+#include "watchdog.hpp"
+#include "result_stream.hpp"
+#include "native_registry.hpp"
+#include "hot_reload.hpp"
 #include "emb.h"
 
 // 应用部分
@@ -14,269 +37,881 @@ class AppException : public std::runtime_error {
     AppException(const char* err) : std::runtime_error(err) {}
 };
 
+// 服务指标,请求路径上只有原子加
+struct ServerMetrics {
+    metrics::RouteMetrics api{"/api"};
+    metrics::RouteMetrics submit{"/submit"};
+    metrics::RouteMetrics submit_stream{"/submit/stream"};  // 只统计到开始发送响应
+    metrics::RouteMetrics kernel{"/kernel"};
+    metrics::RouteMetrics native{"/native"};
+    metrics::RouteMetrics reload{"/admin/reload"};
+    metrics::RouteMetrics scrape{"/metrics"};
+    metrics::Histogram gil_wait;  // 等待获取GIL的时间
+    metrics::Histogram gil_hold;  // 持有GIL的时间
+    metrics::Counter py_exceptions;
+    metrics::Counter script_timeouts;      // 超时被取消的脚本
+    metrics::Counter overload_rejections;  // 拿到GIL时已经超时,没有执行的脚本
+    metrics::Counter stream_rejections;    // 执行中的流式脚本已达上限,没有执行的脚本
+
+    void merge(const ServerMetrics& other) noexcept {
+        api.merge(other.api);
+        submit.merge(other.submit);
+        submit_stream.merge(other.submit_stream);
+        kernel.merge(other.kernel);
+        native.merge(other.native);
+        reload.merge(other.reload);
+        scrape.merge(other.scrape);
+        gil_wait.merge(other.gil_wait);
+        gil_hold.merge(other.gil_hold);
+        py_exceptions.merge(other.py_exceptions);
+        script_timeouts.merge(other.script_timeouts);
+        overload_rejections.merge(other.overload_rejections);
+        stream_rejections.merge(other.stream_rejections);
+    }
+};
+
+/**
+ * @brief 所有进程共享的指标,在fork前映射到匿名共享内存中
+ * @details 每个worker只写自己的槽,`/metrics`由任意一个worker汇总所有槽后输出.
+ * worker重启后沿用原来的槽,计数不会回退.
+ */
+struct SharedMetrics {
+    static constexpr int MAX_WORKERS = 64;
+    std::atomic<int> workers{0};
+    metrics::Counter worker_restarts;
+    std::array<ServerMetrics, MAX_WORKERS> slots;
+};
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "metrics in shared memory require lock-free atomics");
+
+SharedMetrics* shared_metrics = nullptr;
+ServerMetrics* server_metrics = nullptr;  // 当前进程写入的槽
+
+std::chrono::milliseconds script_budget{5000};  // 脚本从请求到达起最多可用的时间,包括等待GIL的时间
+ScriptWatchdog* script_watchdog = nullptr;
+
+EmbModules emb_modules;            // 宿主对`emb`的调用都通过当前版本进行
+std::filesystem::path module_dir;  // 查找`emb.<版本>.so`的目录
+std::mutex reload_mutex;           // 同一时间只进行一次热重载
+
 /**
- * @fn BINARY_VECTOR_P VEC_init(float,float)
- * @brief 相对通用的初始化python解释器函数
- * @param[programname]  应用名.
- * @param[envpath]  虚拟环境路径.为NULL则不使用虚拟环境;为相对路径则从应用所在文件夹开始查找
- * @param[pymodulepath]  python模块的额外查找路径.为NULL则将当前应用所在文件夹加入;为相对路径则从应用所在文件夹开始查找
- * @param[pyhomepath]  设置python_home.为相对路径则从应用所在文件夹开始查找.如果`isolated`为true则不能为NULL
- * @param[tabs] 需要预先加载的模块名模块初始化函数信息
- * @param[isolated]  是否使用隔离配置初始化python解释器
- * @param[debugmod]  是否打印debug用的文本
- * @return void
- * @exception <AppException> { 应用级别异常 }
+ * @fn SharedMetrics* create_shared_metrics()
+ * @brief 映射匿名共享内存并构造`SharedMetrics`,fork出的子进程会共享同一块内存
+ * @exception <AppException> { 映射失败 }
  */
-void init_py(char* programname,
-             char* envpath,
-             char* pymodulepath,
-             char* pyhomepath,
-             const std::map<std::string, PyObject* (*)(void)>* tabs,
-             bool isolated,
-             bool debugmod) {
-    // 参数校验变量赋值
-    if (programname == NULL) {
-        throw AppException("Fatal error: programname must set");
-    }
-    wchar_t* program;
-    auto guard_program = sg::make_scope_guard([&program]() noexcept { PyMem_RawFree(program); });
-    program = Py_DecodeLocale(programname, NULL);
-    if (program == NULL) {
-        throw AppException("Fatal error: cannot decode programname");
-    }
-
-    // 初始化
-    if (isolated) {
-        // 预设置
-        PyStatus statusp;
-        PyPreConfig preconfig;
-        PyPreConfig_InitIsolatedConfig(&preconfig);
-        preconfig.utf8_mode = 1;
-        statusp = Py_PreInitialize(&preconfig);
-        if (PyStatus_Exception(statusp)) {
-            Py_ExitStatusException(statusp);
+SharedMetrics* create_shared_metrics() {
+    void* mem = mmap(NULL, sizeof(SharedMetrics), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        throw AppException("Cannot map shared memory for metrics");
+    }
+    return new (mem) SharedMetrics();
+}
+
+/**
+ * @fn std::string render_metrics()
+ * @brief 以Prometheus文本格式输出服务指标
+ * @details 解释器内存指标需要持有GIL读取,只在`/metrics`请求中进行,不影响其他请求路径.
+ * 开启了`tracemalloc`时额外输出其统计的当前/峰值内存.
+ * @return std::string
+ */
+std::string render_metrics() {
+    std::string out;
+    ServerMetrics total;
+    int workers = shared_metrics->workers.load(std::memory_order_relaxed);
+    for (int i = 0; i < workers; ++i) {
+        total.merge(shared_metrics->slots[i]);
+    }
+    const metrics::RouteMetrics* routes[] = {&total.api, &total.submit, &total.submit_stream, &total.kernel, &total.native, &total.reload, &total.scrape};
+    out += "# HELP http_requests_total Total HTTP requests by route and status class.\n";
+    out += "# TYPE http_requests_total counter\n";
+    for (auto route : routes) {
+        route->render_requests(out);
+    }
+    out += "# HELP http_request_duration_seconds HTTP request latency.\n";
+    out += "# TYPE http_request_duration_seconds histogram\n";
+    for (auto route : routes) {
+        route->render_latency(out);
+    }
+    out += "# HELP python_gil_wait_seconds Time spent waiting to acquire the GIL.\n";
+    out += "# TYPE python_gil_wait_seconds histogram\n";
+    total.gil_wait.render(out, "python_gil_wait_seconds");
+    out += "# HELP python_gil_hold_seconds Time the GIL was held by a request.\n";
+    out += "# TYPE python_gil_hold_seconds histogram\n";
+    total.gil_hold.render(out, "python_gil_hold_seconds");
+    out += "# HELP python_exceptions_total Python exceptions raised by submitted scripts.\n";
+    out += "# TYPE python_exceptions_total counter\n";
+    out += "python_exceptions_total " + std::to_string(total.py_exceptions.get()) + "\n";
+    out += "# HELP python_script_timeouts_total Submitted scripts cancelled after exceeding their deadline.\n";
+    out += "# TYPE python_script_timeouts_total counter\n";
+    out += "python_script_timeouts_total " + std::to_string(total.script_timeouts.get()) + "\n";
+    out += "# HELP python_overload_rejections_total Submitted scripts rejected because their deadline passed while waiting for the GIL.\n";
+    out += "# TYPE python_overload_rejections_total counter\n";
+    out += "python_overload_rejections_total " + std::to_string(total.overload_rejections.get()) + "\n";
+    out += "# HELP python_stream_rejections_total Streamed scripts rejected because too many streams were already running.\n";
+    out += "# TYPE python_stream_rejections_total counter\n";
+    out += "python_stream_rejections_total " + std::to_string(total.stream_rejections.get()) + "\n";
+    out += "# HELP server_workers Worker processes serving requests.\n";
+    out += "# TYPE server_workers gauge\n";
+    out += "server_workers " + std::to_string(workers) + "\n";
+    out += "# HELP server_worker_restarts_total Worker processes restarted by the master.\n";
+    out += "# TYPE server_worker_restarts_total counter\n";
+    out += "server_worker_restarts_total " + std::to_string(shared_metrics->worker_restarts.get()) + "\n";
+
+    // 解释器内存,多进程模式下是响应这次请求的worker的解释器
+    pyembed::GilGuard gil;
+    auto pSys = PyImport_ImportModule("sys");
+    auto guard_pSys = sg::make_scope_guard([&pSys]() noexcept { Py_XDECREF(pSys); });
+    if (pSys != NULL) {
+        auto blocks = PyObject_CallMethod(pSys, "getallocatedblocks", NULL);
+        auto guard_blocks = sg::make_scope_guard([&blocks]() noexcept { Py_XDECREF(blocks); });
+        if (blocks != NULL) {
+            out += "# HELP python_allocated_blocks Memory blocks currently allocated by the interpreter.\n";
+            out += "# TYPE python_allocated_blocks gauge\n";
+            out += "python_allocated_blocks " + std::to_string(PyLong_AsLongLong(blocks)) + "\n";
         }
     }
-    // 基本设置
-    //  隔离模式
-    PyStatus status;
-    PyConfig config;
-    if (isolated) {
-        PyConfig_InitIsolatedConfig(&config);
-    } else {
-        PyConfig_InitPythonConfig(&config);
-    }
-    auto guard_config = sg::make_scope_guard([&config]() noexcept {
-        PyConfig_Clear(&config);
-        printf("python init config clear\n");
-    });
-    // 设置python程序名
-    status = PyConfig_SetString(&config, &config.program_name, program);
-    if (PyStatus_Exception(status)) {
-        throw AppException("Fatal error: InitPythonConfig set program_name get error");
+    auto pTracemalloc = PyImport_ImportModule("tracemalloc");
+    auto guard_pTracemalloc = sg::make_scope_guard([&pTracemalloc]() noexcept { Py_XDECREF(pTracemalloc); });
+    if (pTracemalloc != NULL) {
+        auto traced = PyObject_CallMethod(pTracemalloc, "get_traced_memory", NULL);
+        auto guard_traced = sg::make_scope_guard([&traced]() noexcept { Py_XDECREF(traced); });
+        long long current = 0, peak = 0;
+        // 没有开启tracemalloc时返回(0, 0),此时不输出
+        if (traced != NULL && PyArg_ParseTuple(traced, "LL", &current, &peak) && (current != 0 || peak != 0)) {
+            out += "# HELP python_tracemalloc_bytes Memory traced by tracemalloc.\n";
+            out += "# TYPE python_tracemalloc_bytes gauge\n";
+            out += "python_tracemalloc_bytes{kind=\"current\"} " + std::to_string(current) + "\n";
+            out += "python_tracemalloc_bytes{kind=\"peak\"} " + std::to_string(peak) + "\n";
+        }
+    }
+    if (PyErr_Occurred()) {
+        PyErr_Clear();
     }
+    return out;
+}
+
+/**
+ * @brief 脚本的执行结果
+ */
+enum class ScriptOutcome {
+    OK,        // 正常结束
+    REJECTED,  // 等到GIL时已经超时,没有执行
+    TIMEOUT,   // 执行中超时被取消
+    ERROR,     // 脚本抛出了异常
+};
 
-    // 设置python_home
-    wchar_t* pyhome;
-    auto guard_pyhome = sg::make_scope_guard([&pyhome, &pyhomepath]() noexcept {
-        if (pyhomepath != NULL) {
-            PyMem_RawFree(pyhome);
+/**
+ * @fn bool read_script(crow::multipart::message&, std::string&)
+ * @brief 读出请求中的`script`部分
+ * @param[msg]  请求
+ * @param[code]  输出的脚本
+ * @return bool 没有`script`部分或者脚本为空时返回false
+ */
+bool read_script(crow::multipart::message& msg, std::string& code) {
+    // 缺少的部分用`get_part_by_name`取会解引用`part_map.end()`
+    auto script_part = msg.part_map.find("script");
+    if (script_part == msg.part_map.end()) {
+        return false;
+    }
+    code = script_part->second.body;
+    return !code.empty();
+}
+
+/**
+ * @fn bool parse_deadline(crow::multipart::message&, std::chrono::steady_clock::time_point, std::chrono::steady_clock::time_point&)
+ * @brief 计算脚本的截止时间,默认为请求到达后`script_budget`
+ * @param[msg]  请求,可选的`timeout_ms`部分设置更短的截止时间
+ * @param[arrived]  请求到达的时间
+ * @param[deadline]  输出的截止时间
+ * @return bool `timeout_ms`不合法时返回false
+ */
+bool parse_deadline(crow::multipart::message& msg, std::chrono::steady_clock::time_point arrived,
+                    std::chrono::steady_clock::time_point& deadline) {
+    auto budget = script_budget;
+    // `get_part_by_name`不检查部分是否存在,可选的部分要先查`part_map`
+    auto timeout_part = msg.part_map.find("timeout_ms");
+    if (timeout_part != msg.part_map.end()) {
+        const std::string& timeout_str = timeout_part->second.body;
+        char* end = nullptr;
+        long long timeout_ms = std::strtoll(timeout_str.c_str(), &end, 10);
+        if (end == timeout_str.c_str() || *end != '\0' || timeout_ms <= 0) {
+            return false;
         }
+        // 只能缩短,不能超过服务端的上限
+        budget = std::min(budget, std::chrono::milliseconds(timeout_ms));
+    }
+    deadline = arrived + budget;
+    return true;
+}
+
+/**
+ * @fn ScriptOutcome run_script(const EmbVersion& emb, const char* code, std::chrono::steady_clock::time_point deadline, int& result)
+ * @brief 获取GIL并执行脚本,记录GIL和脚本相关的指标
+ * @details 等到GIL时已经超时则不执行;执行中超时由`script_watchdog`在脚本中抛出`TimeoutError`.
+ * @param[emb]  请求开始时的`emb`版本
+ * @param[code]  脚本
+ * @param[deadline]  截止时间
+ * @param[result]  正常结束时写入`get_numargsc()`
+ * @return ScriptOutcome
+ */
+ScriptOutcome run_script(const EmbVersion& emb, const char* code, std::chrono::steady_clock::time_point deadline, int& result) {
+    auto gil_wait_start = std::chrono::steady_clock::now();
+    pyembed::GilGuard gil;
+    auto gil_acquired = std::chrono::steady_clock::now();
+    server_metrics->gil_wait.record(gil_acquired - gil_wait_start);
+    if (gil_acquired >= deadline) {
+        // 排队等GIL的时间已经用完了预算,执行了结果也没人等,直接拒绝让队列尽快排空
+        server_metrics->overload_rejections.inc();
+        CROW_LOG_WARNING << "deadline passed while waiting for the GIL";
+        return ScriptOutcome::REJECTED;
+    }
+    // 先于gil析构,在释放GIL前记录持有时间
+    auto guard_gil_hold = sg::make_scope_guard([&gil_acquired]() noexcept {
+        server_metrics->gil_hold.record(std::chrono::steady_clock::now() - gil_acquired);
+        CROW_LOG_INFO << "PyGILState_Release ok";
     });
-    if (pyhomepath != NULL) {
-        std::filesystem::path pyhome_dir = pyhomepath;
-        if (pyhome_dir.is_relative()) {
-            pyhome_dir = std::filesystem::absolute(pyhome_dir);
+    CROW_LOG_INFO << "PyGILState_Ensure ok";
+    /* Perform Python actions here. */
+    CROW_LOG_INFO << std::format("submit code {}", code);
+    // 每个脚本在新的全局命名空间中执行,不共享`__main__`.
+    // 否则之前的脚本`import emb`留下的绑定在热重载后仍然指向旧版本
+    pyembed::PyRef globals(PyDict_New());
+    pyembed::PyRef main_name(PyUnicode_FromString("__main__"));
+    if (!globals || !main_name || PyDict_SetItemString(globals.get(), "__builtins__", PyEval_GetBuiltins()) != 0 ||
+        PyDict_SetItemString(globals.get(), "__name__", main_name.get()) != 0) {
+        PyErr_Print();
+        server_metrics->py_exceptions.inc();
+        return ScriptOutcome::ERROR;
+    }
+    int res;
+    bool timed_out;
+    {
+        auto watch = script_watchdog->watch(deadline);
+        pyembed::PyRef ret(PyRun_String(code, Py_file_input, globals.get(), globals.get()));
+        res = ret ? 0 : -1;
+        if (!ret) {
+            PyErr_Print();
         }
-        const char* _pyhome_dir_name = nullptr;
-        {
-            auto _pyhome_dir_name_str = pyhome_dir.string();
-            _pyhome_dir_name = _pyhome_dir_name_str.c_str();
+        timed_out = watch.timed_out();
+    }
+    if (timed_out) {
+        server_metrics->script_timeouts.inc();
+        CROW_LOG_WARNING << "Python code cancelled after deadline";
+        return ScriptOutcome::TIMEOUT;
+    }
+    if (res != 0) {
+        server_metrics->py_exceptions.inc();
+        CROW_LOG_ERROR << "Python code get error";
+        return ScriptOutcome::ERROR;
+    }
+    CROW_LOG_INFO << "PyRun_String ok";
+    result = emb.api.get_numargsc();
+    return ScriptOutcome::OK;
+}
+
+/**
+ * @fn crow::response submit(const crow::request&)
+ * @brief 执行请求中的python脚本
+ * @details 截止时间见`parse_deadline`.等到GIL时已经超时返回503,执行中超时返回408.
+ * @param[req]  请求,脚本放在multipart的`script`部分,可选的`timeout_ms`部分设置更短的截止时间
+ * @return crow::response
+ */
+crow::response submit(const crow::request& req) {
+    auto arrived = std::chrono::steady_clock::now();
+    crow::multipart::message msg(req);
+    std::string code_str;
+    std::chrono::steady_clock::time_point deadline;
+    if (!read_script(msg, code_str) || !parse_deadline(msg, arrived, deadline)) {
+        return crow::response(crow::status::BAD_REQUEST);  // same as crow::response(400)
+    }
+    int result = 0;
+    auto emb = emb_modules.current();
+    switch (run_script(*emb, code_str.c_str(), deadline, result)) {
+        case ScriptOutcome::OK: {
+            crow::json::wvalue x({{"status", "ok"}});
+            x["result"] = result;
+            return crow::response(x);
         }
+        case ScriptOutcome::REJECTED:
+            return crow::response(crow::status::SERVICE_UNAVAILABLE);
+        case ScriptOutcome::TIMEOUT:
+            return crow::response(crow::status::REQUEST_TIMEOUT);
+        default:
+            return crow::response(crow::status::INTERNAL_SERVER_ERROR);
+    }
+}
 
-        pyhome = Py_DecodeLocale(_pyhome_dir_name, NULL);
-        if (pyhome == NULL) {
-            throw AppException("Fatal error: cannot decode pyhome");
-        } else {
-            if (debugmod) {
-                printf("use python_home %s \n", pyhome);
+/**
+ * @brief 执行流式脚本的线程,脚本在请求线程之外执行,请求线程负责把结果发给客户端
+ * @details 线程分离执行,回收解释器前需要调用`wait_idle`等待所有脚本结束.
+ * 脚本都有截止时间,等待时间有上限.
+ * 每个流式响应在发送期间占住一个crow的io线程,同时执行的数量有上限,超过时直接拒绝,留出io线程给其他连接.
+ */
+class ScriptRunners {
+   public:
+    /**
+     * @fn set_limit
+     * @brief 设置同时执行的任务数上限,需要在服务开始前调用
+     */
+    void set_limit(int limit) noexcept { limit_ = std::max(1, limit); }
+
+    /**
+     * @fn spawn
+     * @brief 在新线程中执行`task`
+     * @return bool 已经有`limit`个任务在执行时不启动,返回false
+     */
+    template <typename F>
+    bool spawn(F task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (active_ >= limit_) {
+                return false;
             }
+            ++active_;
         }
-        status = PyConfig_SetString(&config, &config.home, pyhome);
-        if (PyStatus_Exception(status)) {
-            throw AppException("Fatal error: InitPythonConfig set home get error");
-        }
-    } else {
-        if (isolated) {
-            throw AppException("Fatal error: isolated config must set pyhomepath");
+        try {
+            std::thread([this, task = std::move(task)]() mutable {
+                task();
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--active_ == 0) {
+                    idle_.notify_all();
+                }
+            }).detach();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --active_;
+            throw;
         }
+        return true;
     }
 
-    // 加载默认配置
-    status = PyConfig_Read(&config);
-    if (PyStatus_Exception(status)) {
-        throw AppException("Fatal error: PyConfig_Read get error");
+    /**
+     * @fn wait_idle
+     * @brief 等待所有线程中的任务结束,需要在不持有GIL时调用
+     */
+    void wait_idle() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return active_ == 0; });
     }
 
-    // 设置python的sys.path用于查找模块
-    wchar_t* pymodule_dir_name;
-    auto guard_pymodule_dir_name = sg::make_scope_guard([&pymodule_dir_name]() noexcept { PyMem_RawFree(pymodule_dir_name); });
-    std::filesystem::path pymodule_dir;
-    if (pymodulepath == NULL) {
-        pymodule_dir = std::filesystem::current_path();
-    } else {
-        pymodule_dir = pymodulepath;
-        if (pymodule_dir.is_relative()) {
-            pymodule_dir = std::filesystem::absolute(pymodule_dir);
-        }
+   private:
+    std::mutex mutex_;
+    std::condition_variable idle_;
+    int active_ = 0;
+    int limit_ = 1;
+};
+
+ScriptRunners script_runners;
+
+constexpr std::size_t STREAM_CAPACITY = 256 * 1024;  // 每个流式请求缓冲的字节数
+constexpr std::size_t STREAM_CHUNK = 16 * 1024;      // 每个chunk最多的字节数
+
+/**
+ * @fn crow::response submit_stream(const crow::request&)
+ * @brief 执行请求中的python脚本,脚本中`emb.emit`输出的结果以Server-Sent Events立即发给客户端
+ * @details 脚本在`script_runners`的线程中执行,结果写入`ResultStream`,请求线程从中读出后以chunked编码发送.
+ * 每条结果是一个`data`事件;脚本结束后发送`end`事件,内容为json,`status`取值`ok`/`rejected`/`timeout`/`error`,
+ * 和`/submit`的200/503/408/500对应.
+ * 客户端读得慢时缓冲会满,`emb.emit`阻塞等待;客户端断开后`emb.emit`抛出`ConnectionAbortedError`.
+ * 执行中的流式脚本已达`script_runners`的上限时不执行,和`/submit`的`rejected`一样返回503.
+ * @param[req]  请求,格式同`/submit`
+ * @return crow::response
+ */
+crow::response submit_stream(const crow::request& req) {
+    auto arrived = std::chrono::steady_clock::now();
+    crow::multipart::message msg(req);
+    std::string code_str;
+    std::chrono::steady_clock::time_point deadline;
+    if (!read_script(msg, code_str) || !parse_deadline(msg, arrived, deadline)) {
+        return crow::response(crow::status::BAD_REQUEST);
     }
-    const char* _pymodule_dir_name = nullptr;
-    {
-        auto _pymodule_dir_name_str = pymodule_dir.string();
-        _pymodule_dir_name = _pymodule_dir_name_str.c_str();
+    auto stream = std::make_shared<ResultStream>(STREAM_CAPACITY, deadline);
+    bool spawned = script_runners.spawn([stream, code_str = std::move(code_str), deadline, emb = emb_modules.current()] {
+        int result = 0;
+        ScriptOutcome outcome;
+        {
+            // `emb.emit`写入的是这个线程的输出流,每个版本的`emb`各有一份,需要通过对应版本设置
+            void* previous = emb->api.bind_result_stream(stream.get());
+            auto guard_binding = sg::make_scope_guard([&emb, previous]() noexcept { emb->api.bind_result_stream(previous); });
+            outcome = run_script(*emb, code_str.c_str(), deadline, result);
+        }
+        crow::json::wvalue x;
+        switch (outcome) {
+            case ScriptOutcome::OK:
+                x["status"] = "ok";
+                x["result"] = result;
+                break;
+            case ScriptOutcome::REJECTED:
+                x["status"] = "rejected";
+                break;
+            case ScriptOutcome::TIMEOUT:
+                x["status"] = "timeout";
+                break;
+            default:
+                x["status"] = "error";
+        }
+        std::string event = "event: end\ndata: " + x.dump() + "\n\n";
+        // 脚本已经结束,结束事件不受截止时间限制,但也不无限等待读得慢的客户端
+        stream->write_until(event.data(), event.size(), std::chrono::steady_clock::now() + std::chrono::seconds(1));
+        stream->close_writer();
+    });
+    if (!spawned) {
+        server_metrics->stream_rejections.inc();
+        CROW_LOG_WARNING << "too many running streams";
+        return crow::response(crow::status::SERVICE_UNAVAILABLE);
     }
+    crow::response res(200);
+    res.set_header("Content-Type", "text/event-stream");
+    res.set_header("Cache-Control", "no-cache");
+    // 响应发送完或者客户端断开后crow释放`body_source`,此时关闭读端,让还在等待的`emb.emit`返回
+    std::shared_ptr<ResultStream> reader(stream.get(), [stream](ResultStream* s) { s->close_reader(); });
+    res.body_source = [reader](std::string& out) { return reader->read(out, STREAM_CHUNK); };
+    return res;
+}
 
-    pymodule_dir_name = Py_DecodeLocale(_pymodule_dir_name, NULL);
-    if (pymodule_dir_name == NULL) {
-        throw AppException("Fatal error: cannot decode pymodule_dir_name");
-    } else {
-        if (debugmod) {
-            printf("pymodule_dir %s \n", _pymodule_dir_name);
+/**
+ * @fn crow::response call_kernel(const crow::request&, const std::string&)
+ * @brief 在请求体上执行`emb`中注册的数值核函数,返回结果的原始字节
+ * @details 请求体和响应体都是原生字节序的`double`数组(`application/octet-stream`),
+ * 请求体直接映射为memoryview,不经过json或multipart解析;结果直接写进响应体.
+ * 只在查找核函数时持有GIL,核函数本身在`nogil`下执行.
+ * @param[req]  请求
+ * @param[name]  核函数名,比如`normalize`,`l2norm`
+ * @return crow::response 没有这个核函数时返回404,请求体不是非空的`double`数组时返回400
+ */
+crow::response call_kernel(const crow::request& req, const std::string& name) {
+    if (req.body.empty() || req.body.size() % sizeof(double) != 0) {
+        return crow::response(crow::status::BAD_REQUEST);
+    }
+    crow::response res(200);
+    // 输出不会比输入长,先按输入的长度分配,执行后截短
+    res.body.resize(req.body.size());
+    Py_ssize_t written;
+    auto emb = emb_modules.current();
+    {
+        auto gil_wait_start = std::chrono::steady_clock::now();
+        pyembed::GilGuard gil;
+        server_metrics->gil_wait.record(std::chrono::steady_clock::now() - gil_wait_start);
+        written = emb->api.run_kernel(name.c_str(), req.body.data(), static_cast<Py_ssize_t>(req.body.size()), res.body.data(),
+                             static_cast<Py_ssize_t>(res.body.size()));
+        if (written == -2) {
+            PyErr_Print();
         }
     }
-    config.module_search_paths_set = 1;
-    status = PyWideStringList_Append(&config.module_search_paths, pymodule_dir_name);
-    if (PyStatus_Exception(status)) {
-        throw AppException("Fatal error: InitPythonConfig set module_search_paths get error");
+    if (written == -1) {
+        return crow::response(crow::status::NOT_FOUND);
+    }
+    if (written < 0) {
+        return crow::response(crow::status::INTERNAL_SERVER_ERROR);
     }
-    // 设置虚拟环境
-    wchar_t* env_dir_name;
-    auto guard_env_dir_name = sg::make_scope_guard([&env_dir_name, &envpath]() noexcept {
-        if (envpath != NULL) {
-            PyMem_RawFree(env_dir_name);
+    res.body.resize(static_cast<std::size_t>(written));
+    res.set_header("Content-Type", "application/octet-stream");
+    return res;
+}
+
+/**
+ * @brief 按签名把请求体转换为参数,调用后把结果写入响应体
+ */
+struct NativeCall {
+    const NativeFunction& function;
+    const std::string& body;
+    crow::response& res;
+
+    void operator()(native_array_f64 fn) const {
+        if (body.empty() || body.size() % sizeof(double) != 0) {
+            res.code = crow::status::BAD_REQUEST;
+            return;
         }
-    });
-    if (envpath != NULL) {
-        std::filesystem::path env_dir = envpath;
-        if (env_dir.is_relative()) {
-            env_dir = std::filesystem::absolute(env_dir);
+        auto n = static_cast<std::ptrdiff_t>(body.size() / sizeof(double));
+        res.body.resize(body.size());
+        // 请求体一般在堆上,满足`double`的对齐;短字符串优化时可能不满足,复制一份
+        std::vector<double> aligned;
+        const double* x = reinterpret_cast<const double*>(body.data());
+        if (reinterpret_cast<std::uintptr_t>(x) % alignof(double) != 0) {
+            aligned.resize(static_cast<std::size_t>(n));
+            std::memcpy(aligned.data(), body.data(), body.size());
+            x = aligned.data();
         }
-        const char* _env_dir_name = nullptr;
-        {
-            auto _env_dir_name_str = env_dir.string();
-            _env_dir_name = _env_dir_name_str.c_str();
+        auto written = fn(x, n, reinterpret_cast<double*>(res.body.data()));
+        res.body.resize(static_cast<std::size_t>(written) * sizeof(double));
+    }
+
+    template <typename T>
+    void scalar(T (*fn)(T)) const {
+        T x;
+        if (body.size() != sizeof(x)) {
+            res.code = crow::status::BAD_REQUEST;
+            return;
         }
+        std::memcpy(&x, body.data(), sizeof(x));
+        T y = fn(x);
+        res.body.assign(reinterpret_cast<const char*>(&y), sizeof(y));
+    }
 
-        env_dir_name = Py_DecodeLocale(_env_dir_name, NULL);
-        if (env_dir_name == NULL) {
-            throw AppException("Fatal error: cannot decode _env_dir_name");
-        } else {
-            if (debugmod) {
-                printf("use virtual environments %s \n", _env_dir_name);
+    void operator()(native_f64_f64 fn) const { scalar(fn); }
+    void operator()(native_i64_i64 fn) const {
+        std::int64_t x;
+        if (body.size() == sizeof(x)) {
+            std::memcpy(&x, body.data(), sizeof(x));
+            if (!function.domain.contains(x)) {
+                res.code = crow::status::BAD_REQUEST;
+                return;
             }
         }
-        status = PyConfig_SetString(&config, &config.prefix, env_dir_name);
-        if (PyStatus_Exception(status)) {
-            throw AppException("Fatal error: InitPythonConfig set prefix get error");
-        }
-        status = PyConfig_SetString(&config, &config.exec_prefix, env_dir_name);
-        if (PyStatus_Exception(status)) {
-            throw AppException("Fatal error: InitPythonConfig set exec_prefix get error");
-        }
+        scalar(fn);
+    }
+};
+
+/**
+ * @fn crow::response call_native(const crow::request&, const std::string&)
+ * @brief 调用当前版本的`emb`等cython模块登记在注册表中的`nogil`函数,全程不获取GIL
+ * @details 按名字在完美哈希表中查找,按函数的签名解释请求体,输入输出都是原生字节序的原始字节:
+ * `array_f64`为`double`数组,`f64_f64`为一个`double`,`i64_i64`为一个`int64`.
+ * @param[req]  请求
+ * @param[name]  函数名
+ * @return crow::response 没有这个函数时返回404,请求体和签名不符或者参数超出登记的范围时返回400
+ */
+crow::response call_native(const crow::request& req, const std::string& name) {
+    auto emb = emb_modules.current();
+    auto table = emb->registry().table();
+    auto function = table->find(name);
+    if (function == nullptr) {
+        return crow::response(crow::status::NOT_FOUND);
+    }
+    crow::response res(200);
+    std::visit(NativeCall{*function, req.body, res}, function->fn);
+    if (res.code != 200) {
+        res.body.clear();
+        return res;
     }
+    res.set_header("Content-Type", "application/octet-stream");
+    return res;
+}
 
-    // 提前初始化模块`emb`
-    if (tabs != NULL) {
-        for (const auto& [key, value] : *tabs) {
-            PyImport_AppendInittab(key.c_str(), value);
+/**
+ * @fn crow::response reload_emb(const std::string& version)
+ * @brief 热重载`emb`:加载`module_dir`下的`emb.<version>.so`,切换过去并等待旧版本上的调用结束
+ * @details 新版本加载后先从旧版本交接状态(目前只有`numargs`),再替换`sys.modules["emb"]`,
+ * 之后开始的请求和脚本使用新版本,已经开始的继续使用旧版本直到结束.
+ * 脚本各自在新的全局命名空间中执行,`import emb`总是从`sys.modules`取到当前版本.
+ * 多进程模式下只重载收到请求的worker.
+ * @param[version]  版本号,只能包含字母,数字,`_`和`-`
+ * @return crow::response 成功时返回json,`drained`表示旧版本是否在超时前排空;
+ * 版本号不合法返回400,文件不存在返回404,正在重载返回409,加载失败返回500
+ */
+crow::response reload_emb(const std::string& version) {
+    if (version.empty() || !std::all_of(version.begin(), version.end(), [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-';
+        })) {
+        return crow::response(crow::status::BAD_REQUEST);
+    }
+    std::unique_lock<std::mutex> lock(reload_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return crow::response(crow::status::CONFLICT);
+    }
+    auto path = module_dir / ("emb." + version + ".so");
+    if (!std::filesystem::exists(path)) {
+        return crow::response(crow::status::NOT_FOUND);
+    }
+    std::shared_ptr<const EmbVersion> next;
+    std::string previous_version;
+    {
+        auto previous = emb_modules.current();
+        previous_version = previous->version;
+        pyembed::GilGuard gil;
+        try {
+            auto loaded = load_emb_version(path, version);
+            loaded->api.set_numargsc(previous->api.get_numargsc());
+            if (PyDict_SetItemString(PyImport_GetModuleDict(), "emb", loaded->module) != 0) {
+                PyErr_Print();
+                return crow::response(crow::status::INTERNAL_SERVER_ERROR);
+            }
+            next = std::move(loaded);
+        } catch (const pyembed::EmbedError& ex) {
+            CROW_LOG_ERROR << ex.what();
+            return crow::response(crow::status::INTERNAL_SERVER_ERROR, ex.what());
         }
     }
+    // 旧版本上最长的调用是脚本,最多执行到截止时间
+    bool drained = emb_modules.swap_and_drain(next, script_budget + std::chrono::seconds(1));
+    CROW_LOG_INFO << std::format("emb reloaded {} -> {}, drained: {}", previous_version, version, drained);
+    crow::json::wvalue x;
+    x["version"] = version;
+    x["previous"] = previous_version;
+    x["drained"] = drained;
+    x["natives"] = next->registry().table()->functions().size();
+    return crow::response(x);
+}
 
-    // 初始化python解释器
-    status = Py_InitializeFromConfig(&config);
-    if (PyStatus_Exception(status)) {
-        if (PyStatus_IsExit(status)) {
-            // return status.exitcode;
-            throw AppException("Fatal error: PyStatus_IsExit");
+/**
+ * @fn int run_server(const char* programname, uint16_t port, bool reuse_port)
+ * @brief 初始化python解释器并运行http服务,直到收到SIGINT或SIGTERM
+ * @param[programname]  应用名
+ * @param[port]  监听的端口
+ * @param[reuse_port]  是否设置SO_REUSEPORT,多进程模式下每个worker各自监听同一个端口
+ * @return int 进程的返回码
+ */
+int run_server(const char* programname, uint16_t port, bool reuse_port) {
+    set_numargsc(10);
+    try {
+        // 初始化python解释器
+        pyembed::Interpreter interp(
+            pyembed::ConfigBuilder(programname).module_path(std::filesystem::current_path()).inittab("emb", PyInit_emb).debug());
+        PyObject* emb_module = interp.handles().module("emb");
+        if (emb_module == NULL) {
+            PyErr_Print();
+            return 1;
         }
-        // 抛出错误
-        Py_ExitStatusException(status);
+        // inittab注册的`emb`是第一个版本
+        emb_modules.swap_and_drain(emb_version_from_module(emb_module, "builtin"), std::chrono::milliseconds(0));
+        module_dir = std::filesystem::current_path();
+        // http接口逻辑
+        crow::SimpleApp app;
+        CROW_ROUTE(app, "/api")
+        ([](const crow::request& req) {
+            metrics::ScopedTimer timer(server_metrics->api.latency);
+            // 结束python调用,转换结果
+            crow::json::wvalue x({{"status", "ok"}});
+            x["result"] = emb_modules.current()->api.get_numargsc();
+            server_metrics->api.count_status(200);
+            return crow::response(x);
+        });
+
+        CROW_ROUTE(app, "/submit").methods("POST"_method)([](const crow::request& req) {
+            metrics::ScopedTimer timer(server_metrics->submit.latency);
+            auto res = submit(req);
+            server_metrics->submit.count_status(res.code);
+            return res;
+        });
+
+        CROW_ROUTE(app, "/submit/stream").methods("POST"_method)([](const crow::request& req) {
+            metrics::ScopedTimer timer(server_metrics->submit_stream.latency);
+            auto res = submit_stream(req);
+            server_metrics->submit_stream.count_status(res.code);
+            return res;
+        });
+
+        CROW_ROUTE(app, "/kernel/<string>").methods("POST"_method)([](const crow::request& req, const std::string& name) {
+            metrics::ScopedTimer timer(server_metrics->kernel.latency);
+            auto res = call_kernel(req, name);
+            server_metrics->kernel.count_status(res.code);
+            return res;
+        });
+
+        CROW_ROUTE(app, "/native")
+        ([]() {
+            metrics::ScopedTimer timer(server_metrics->native.latency);
+            crow::json::wvalue x;
+            for (auto& function : emb_modules.current()->registry().table()->functions()) {
+                x[function.name] = signature_name(function.fn);
+            }
+            server_metrics->native.count_status(200);
+            return crow::response(x);
+        });
+
+        CROW_ROUTE(app, "/native/<string>").methods("POST"_method)([](const crow::request& req, const std::string& name) {
+            metrics::ScopedTimer timer(server_metrics->native.latency);
+            auto res = call_native(req, name);
+            server_metrics->native.count_status(res.code);
+            return res;
+        });
+
+        CROW_ROUTE(app, "/admin/reload/<string>").methods("POST"_method)([](const std::string& version) {
+            metrics::ScopedTimer timer(server_metrics->reload.latency);
+            auto res = reload_emb(version);
+            server_metrics->reload.count_status(res.code);
+            return res;
+        });
+
+        CROW_ROUTE(app, "/metrics")
+        ([]() {
+            metrics::ScopedTimer timer(server_metrics->scrape.latency);
+            crow::response res(200, render_metrics());
+            res.set_header("Content-Type", "text/plain; version=0.0.4");
+            server_metrics->scrape.count_status(200);
+            return res;
+        });
+        {
+            // 主线程在服务运行期间释放GIL,由各个请求线程按需获取
+            pyembed::GilRelease nogil;
+            // 看门狗需要在回收解释器前停止,且析构时不能持有GIL
+            ScriptWatchdog watchdog;
+            script_watchdog = &watchdog;
+            auto guard_watchdog = sg::make_scope_guard([]() noexcept { script_watchdog = nullptr; });
+            // 流式脚本可能还在执行,需要在看门狗停止前等它们结束
+            auto guard_runners = sg::make_scope_guard([]() noexcept { script_runners.wait_idle(); });
+            app.loglevel(crow::LogLevel::Info).port(port).reuse_port(reuse_port).multithreaded().run();
+        }
+        return interp.finalize();
+    } catch (const pyembed::EmbedError& ex) {
+        fprintf(stderr, "%s", ex.what());
+        return 1;
     }
-    if (debugmod) {
-        PyRun_SimpleString("import sys;print(sys.path);print(sys.prefix)");
+}
+
+static volatile sig_atomic_t master_stopping = 0;
+
+static void on_master_signal(int) { master_stopping = 1; }
+
+/**
+ * @fn int reserve_port(uint16_t port)
+ * @brief 主进程绑定(但不监听)一个设置了SO_REUSEPORT的套接字,占住端口
+ * @details 内核只把连接分给处于监听状态的套接字,主进程的这个套接字不会接走请求.
+ * 它让端口被占用时在fork之前就报错,并且在worker全部重启的间隙端口也不会被其他用户的进程抢走.
+ * @return int 套接字,失败时返回-1
+ */
+int reserve_port(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int on = 1;
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0 ||
+        bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
     }
+    return fd;
 }
 
-int finalize_py() {
-    if (Py_FinalizeEx() < 0) {
-        return 120;
+/**
+ * @fn pid_t spawn_worker(const char* programname, uint16_t port, int index, int reserved_fd)
+ * @brief fork一个worker,worker在子进程中初始化自己的python解释器并导入`emb`
+ * @param[index]  worker的编号,决定它写入共享指标中的哪个槽
+ * @return pid_t 子进程号,失败时返回-1
+ */
+pid_t spawn_worker(const char* programname, uint16_t port, int index, int reserved_fd) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(reserved_fd);
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        server_metrics = &shared_metrics->slots[index];
+        std::exit(run_server(programname, port, true));
     }
-    printf("finalize_py ok\n");
-    return 0;
+    return pid;
 }
-PyObject* init_pymodule(char* Module_Name) {
-    auto pName = PyUnicode_DecodeFSDefault(Module_Name);  // 将模块名类型转为python对象字符串
-    auto guard = sg::make_scope_guard([&pName]() noexcept {
-        Py_DECREF(pName);  // 释放对象pName的gc计数器
-    });
-    auto pModule = PyImport_Import(pName);  // 导入模块
-    return pModule;
+
+/**
+ * @fn int run_master(const char* programname, uint16_t port, int workers)
+ * @brief 多进程模式的主进程,启动并监控`workers`个worker,异常退出的worker会被重新拉起
+ * @details 主进程不初始化python解释器,fork时只有一个线程,没有fork和多线程混用的问题.
+ * 收到SIGINT或SIGTERM后向所有worker发送SIGTERM并等待它们退出.
+ * @return int 进程的返回码
+ */
+int run_master(const char* programname, uint16_t port, int workers) {
+    int reserved_fd = reserve_port(port);
+    if (reserved_fd < 0) {
+        perror("Cannot reserve port");
+        return 1;
+    }
+    struct sigaction sa = {};
+    sa.sa_handler = on_master_signal;
+    sigemptyset(&sa.sa_mask);
+    // 不设置SA_RESTART,让阻塞中的waitpid以EINTR返回
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    shared_metrics->workers.store(workers, std::memory_order_relaxed);
+    std::vector<pid_t> pids(workers, -1);
+    std::vector<std::chrono::steady_clock::time_point> started(workers);
+    for (int i = 0; i < workers; ++i) {
+        pids[i] = spawn_worker(programname, port, i, reserved_fd);
+        started[i] = std::chrono::steady_clock::now();
+    }
+    while (!master_stopping) {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != ECHILD) {
+                perror("waitpid");
+                break;
+            }
+            // fork全部失败时没有子进程可等,稍后重试
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+        for (int i = 0; i < workers && !master_stopping; ++i) {
+            if (pids[i] > 0 && pids[i] != pid) {
+                continue;
+            }
+            if (pids[i] > 0) {
+                if (WIFSIGNALED(status)) {
+                    fprintf(stderr, "worker %d (pid %d) killed by signal %d\n", i, pid, WTERMSIG(status));
+                } else {
+                    fprintf(stderr, "worker %d (pid %d) exited with status %d\n", i, pid, WEXITSTATUS(status));
+                }
+                shared_metrics->worker_restarts.inc();
+            }
+            // 启动后很快就退出的worker(比如初始化失败)等待1秒再重启,避免空转
+            if (std::chrono::steady_clock::now() - started[i] < std::chrono::seconds(1)) {
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+            }
+            pids[i] = spawn_worker(programname, port, i, reserved_fd);
+            started[i] = std::chrono::steady_clock::now();
+        }
+    }
+    for (auto pid : pids) {
+        if (pid > 0) {
+            kill(pid, SIGTERM);
+        }
+    }
+    for (auto pid : pids) {
+        while (pid > 0 && waitpid(pid, NULL, 0) < 0 && errno == EINTR) {
+        }
+    }
+    close(reserved_fd);
+    return 0;
 }
 
+/**
+ * 用法: ./cythonembeddingc [-p 端口,默认18080] [-w worker数] [-t 脚本超时毫秒数,默认5000]
+ *
+ * 不指定`-w`时在当前进程中运行;指定后以多进程模式运行,每个worker各有一个python解释器,
+ * CPU密集的python脚本可以用满多个核.
+ */
 int main(int argc, char* argv[]) {
-    // 初始化python解释器
+    uint16_t port = 18080;
+    int workers = 0;
+    // 默认最多占用一半的io线程,crow至少有2个线程
+    int max_streams = std::max(2u, std::thread::hardware_concurrency()) / 2;
+    int ch;
+    while ((ch = getopt(argc, argv, "p:w:t:s:")) != -1) {
+        switch (ch) {
+            case 'p':
+                port = static_cast<uint16_t>(atoi(optarg));
+                break;
+            case 'w':
+                workers = atoi(optarg);
+                break;
+            case 't':
+                script_budget = std::chrono::milliseconds(std::max(1, atoi(optarg)));
+                break;
+            case 's':
+                max_streams = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-p port] [-w workers] [-t timeout_ms] [-s max_streams]\n", argv[0]);
+                return 1;
+        }
+    }
+    script_runners.set_limit(max_streams);
     try {
-        set_numargsc(10);
-        std::map<std::string, PyObject* (*)(void)> tabs{{"emb", PyInit_emb}};
-        init_py(argv[0], NULL, NULL, NULL, &tabs, false, true);
+        shared_metrics = create_shared_metrics();
     } catch (const AppException& ex) {
-        fprintf(stderr, ex.what());
+        fprintf(stderr, "%s", ex.what());
         return 1;
     }
-    auto pModule = init_pymodule((char*)"emb");
-    auto guard_pModule = sg::make_scope_guard([&pModule]() noexcept {
-        Py_XDECREF(pModule);  // 释放pModule
-    });
-    // http接口逻辑
-    crow::SimpleApp app;
-    CROW_ROUTE(app, "/api")
-    ([](const crow::request& req) {
-        // 结束python调用,转换结果
-        crow::json::wvalue x({{"status", "ok"}});
-        x["result"] = get_numargsc();
-        return crow::response(x);
-    });
-
-    CROW_ROUTE(app, "/submit").methods("POST"_method)([](const crow::request& req) {
-        crow::multipart::message msg(req);
-        std::string code_str = msg.get_part_by_name("script").body;
-        if (code_str.empty()) {
-            return crow::response(crow::status::BAD_REQUEST);  // same as crow::response(400)
-        }
-        auto code = code_str.c_str();
-        // 开始执行python调用
-        // // PyGILState_STATE gstate;
-        auto _save = PyEval_SaveThread();
-        auto gstate = PyGILState_Ensure();
-        auto guard_gstate = sg::make_scope_guard([&gstate, &_save]() noexcept {
-            PyGILState_Release(gstate);
-            PyEval_RestoreThread(_save);
-            CROW_LOG_INFO << "PyGILState_Release ok";
-        });
-        CROW_LOG_INFO << "PyGILState_Ensure ok";
-        /* Perform Python actions here. */
-        CROW_LOG_INFO << std::format("submit code {}", code);
-        int res = PyRun_SimpleString(code);
-        if (res == 0) {
-            CROW_LOG_INFO << "PyRun_SimpleString ok";
-            crow::json::wvalue x({{"status", "ok"}});
-            x["result"] = get_numargs();
-            return crow::response(x);
-        } else {
-            CROW_LOG_ERROR << "Python code get error";
-            return crow::response(crow::status::INTERNAL_SERVER_ERROR);
-        }
-    });
-    app.loglevel(crow::LogLevel::Info).port(18080).multithreaded().run();
-    return finalize_py();
+    if (workers <= 0) {
+        shared_metrics->workers.store(1, std::memory_order_relaxed);
+        server_metrics = &shared_metrics->slots[0];
+        return run_server(argv[0], port, false);
+    }
+    return run_master(argv[0], port, std::min(workers, SharedMetrics::MAX_WORKERS));
 }
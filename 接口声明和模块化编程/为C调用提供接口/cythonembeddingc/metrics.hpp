@@ -0,0 +1,185 @@
+/**
+ * @file metrics.hpp
+ * @brief 服务的运行指标采集,以Prometheus文本格式导出
+ *
+ * 请求路径上只做`std::atomic`的`fetch_add`(relaxed),不加锁也不分配内存;
+ * 汇总和格式化只在`/metrics`被访问时进行.
+ * 计数都是无锁的原子量,可以直接放在多个进程共享的内存中.
+ */
+#ifndef METRICS_HPP_
+#define METRICS_HPP_
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace metrics {
+
+/**
+ * @brief 单调递增计数器
+ */
+class Counter {
+   public:
+    void inc(std::uint64_t n = 1) noexcept { value_.fetch_add(n, std::memory_order_relaxed); }
+    std::uint64_t get() const noexcept { return value_.load(std::memory_order_relaxed); }
+    void merge(const Counter& other) noexcept { inc(other.get()); }
+
+   private:
+    std::atomic<std::uint64_t> value_{0};
+};
+
+/**
+ * @brief HdrHistogram风格的对数-线性分桶直方图,单位为微秒
+ *
+ * 每个2的幂区间再线性切分为`SUB_BUCKETS`个子桶,因此相对误差不超过1/SUB_BUCKETS;
+ * 桶下标只靠位运算算出,记录一次只有两次原子加.
+ * 覆盖范围为[0, 2^MAX_MAGNITUDE)微秒(约67秒),共`BUCKETS`个有限的桶;超出的值计入下标为`BUCKETS`的溢出桶,只体现在`+Inf`中.
+ */
+class Histogram {
+   public:
+    static constexpr int SUB_BITS = 2;
+    static constexpr std::uint64_t SUB_BUCKETS = 1u << SUB_BITS;
+    static constexpr int MAX_MAGNITUDE = 26;
+    static constexpr std::size_t BUCKETS = SUB_BUCKETS + (MAX_MAGNITUDE - SUB_BITS) * SUB_BUCKETS;
+    static constexpr std::size_t OVERFLOW_BUCKET = BUCKETS;
+
+    void record(std::uint64_t us) noexcept {
+        buckets_[index_of(us)].fetch_add(1, std::memory_order_relaxed);
+        sum_us_.fetch_add(us, std::memory_order_relaxed);
+    }
+
+    template <typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> d) noexcept {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+        record(us < 0 ? 0 : static_cast<std::uint64_t>(us));
+    }
+
+    /**
+     * @brief 把另一个直方图的计数累加进来,用于汇总多个进程的指标
+     */
+    void merge(const Histogram& other) noexcept {
+        for (std::size_t i = 0; i <= OVERFLOW_BUCKET; ++i) {
+            buckets_[i].fetch_add(other.buckets_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        sum_us_.fetch_add(other.sum_us_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 计算值落入的桶下标
+     */
+    static constexpr std::size_t index_of(std::uint64_t us) noexcept {
+        if (us < SUB_BUCKETS) {
+            return static_cast<std::size_t>(us);
+        }
+        int magnitude = std::bit_width(us) - 1;  // floor(log2(us))
+        if (magnitude >= MAX_MAGNITUDE) {
+            return OVERFLOW_BUCKET;
+        }
+        auto sub = (us >> (magnitude - SUB_BITS)) & (SUB_BUCKETS - 1);
+        return SUB_BUCKETS + (magnitude - SUB_BITS) * SUB_BUCKETS + sub;
+    }
+
+    /**
+     * @brief 桶的上界(包含),单位为微秒
+     */
+    static constexpr std::uint64_t upper_bound_of(std::size_t index) noexcept {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        auto magnitude = (index - SUB_BUCKETS) / SUB_BUCKETS + SUB_BITS;
+        auto sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub + 1) << (magnitude - SUB_BITS)) - 1;
+    }
+
+    /**
+     * @brief 以Prometheus的histogram格式输出,`le`以秒为单位
+     * @param[out]  输出缓冲
+     * @param[name]  指标名
+     * @param[labels]  额外的标签,形如`route="/api"`,可以为空
+     */
+    void render(std::string& out, const char* name, const std::string& labels = "") const {
+        std::string sep = labels.empty() ? "" : ",";
+        std::uint64_t cumulative = 0;
+        for (std::size_t i = 0; i < BUCKETS; ++i) {
+            // 桶集合保持固定,空桶也输出,否则`le`标签集合会随时间变化
+            cumulative += buckets_[i].load(std::memory_order_relaxed);
+            out += std::string(name) + "_bucket{" + labels + sep + "le=\"" + std::to_string(upper_bound_of(i) / 1e6) + "\"} " +
+                   std::to_string(cumulative) + "\n";
+        }
+        cumulative += buckets_[OVERFLOW_BUCKET].load(std::memory_order_relaxed);
+        out += std::string(name) + "_bucket{" + labels + sep + "le=\"+Inf\"} " + std::to_string(cumulative) + "\n";
+        out += std::string(name) + "_sum" + (labels.empty() ? "" : "{" + labels + "}") + " " +
+               std::to_string(sum_us_.load(std::memory_order_relaxed) / 1e6) + "\n";
+        out += std::string(name) + "_count" + (labels.empty() ? "" : "{" + labels + "}") + " " + std::to_string(cumulative) + "\n";
+    }
+
+   private:
+    std::array<std::atomic<std::uint64_t>, BUCKETS + 1> buckets_{};
+    std::atomic<std::uint64_t> sum_us_{0};
+};
+// 最后一个有限桶的上界正好是覆盖范围的上界,溢出的值不会和它共用一个桶
+static_assert(Histogram::index_of((1ull << Histogram::MAX_MAGNITUDE) - 1) == Histogram::BUCKETS - 1);
+static_assert(Histogram::upper_bound_of(Histogram::BUCKETS - 1) == (1ull << Histogram::MAX_MAGNITUDE) - 1);
+static_assert(Histogram::index_of(1ull << Histogram::MAX_MAGNITUDE) == Histogram::OVERFLOW_BUCKET);
+
+/**
+ * @brief 计时器,析构时将经过的时间记录到直方图
+ */
+class ScopedTimer {
+   public:
+    explicit ScopedTimer(Histogram& h) noexcept : hist_(h), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { hist_.record(std::chrono::steady_clock::now() - start_); }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+   private:
+    Histogram& hist_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief 单个路由的指标
+ */
+struct RouteMetrics {
+    const char* route;
+    Counter status_2xx;
+    Counter status_4xx;
+    Counter status_5xx;
+    Histogram latency;
+
+    void count_status(int code) noexcept {
+        if (code >= 500) {
+            status_5xx.inc();
+        } else if (code >= 400) {
+            status_4xx.inc();
+        } else {
+            status_2xx.inc();
+        }
+    }
+
+    void merge(const RouteMetrics& other) noexcept {
+        status_2xx.merge(other.status_2xx);
+        status_4xx.merge(other.status_4xx);
+        status_5xx.merge(other.status_5xx);
+        latency.merge(other.latency);
+    }
+
+    // Prometheus要求同一指标族的样本连续出现,因此计数和耗时分开输出
+    std::string label() const { return std::string("route=\"") + route + "\""; }
+
+    void render_requests(std::string& out) const {
+        auto l = label();
+        out += "http_requests_total{" + l + ",code=\"2xx\"} " + std::to_string(status_2xx.get()) + "\n";
+        out += "http_requests_total{" + l + ",code=\"4xx\"} " + std::to_string(status_4xx.get()) + "\n";
+        out += "http_requests_total{" + l + ",code=\"5xx\"} " + std::to_string(status_5xx.get()) + "\n";
+    }
+
+    void render_latency(std::string& out) const { latency.render(out, "http_request_duration_seconds", label()); }
+};
+
+}  // namespace metrics
+
+#endif /* METRICS_HPP_ */
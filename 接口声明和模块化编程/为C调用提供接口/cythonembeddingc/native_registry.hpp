@@ -0,0 +1,236 @@
+/**
+ * @file native_registry.hpp
+ * @brief cython代码注册的`nogil`函数指针表,C++宿主按名字直接调用,不经过python也不需要GIL
+ *
+ * 每个函数带有类型化的签名(`NativeFn`中的一种),调用方按签名解释输入输出.
+ * 函数本身没有报错的途径,`i64_i64`的函数可以在登记时给出参数范围,由调用方在调用前检查.
+ * cython模块导入时用`add`登记函数,登记完后`publish`,把当前所有函数构造成一张完美哈希表并原子地替换掉旧表.
+ * 表构造后不可修改,读取方拿到的`shared_ptr`在使用期间一直有效,查找和调用都不加锁.
+ *
+ * 完美哈希用的是种子搜索:对固定的名字集合寻找一个种子,使所有名字在2的幂大小的槽位中互不冲突,
+ * 查找只需要一次哈希和一次字符串比较.注册的函数一般只有几十个,搜索在构造时很快完成.
+ *
+ * 由`emb.pyx`通过`cdef extern`使用.每个加载的`emb`版本有自己的单例,宿主通过`EmbApi::native_registry`取得.
+ * 单例是内部链接的:带外部链接的函数内静态变量会被编译为`STB_GNU_UNIQUE`符号,
+ * 动态加载器会把所有`emb.<版本>.so`中的这份变量合并成一个,`-Wl,-Bsymbolic`也不能避免.
+ */
+#ifndef NATIVE_REGISTRY_HPP_
+#define NATIVE_REGISTRY_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// 数组到数组:读取`n`个输入写入输出,返回写入的个数,输出的容量为`n`
+// cython生成的函数不带C++的`noexcept`,这里的类型也不能带,否则函数指针不能隐式转换
+using native_array_f64 = std::ptrdiff_t (*)(const double* x, std::ptrdiff_t n, double* out);
+// 标量到标量
+using native_f64_f64 = double (*)(double x);
+using native_i64_i64 = std::int64_t (*)(std::int64_t x);
+
+using NativeFn = std::variant<native_array_f64, native_f64_f64, native_i64_i64>;
+
+/**
+ * @brief 签名的名字,和`NativeFn`中的顺序一致
+ */
+inline const char* signature_name(const NativeFn& fn) noexcept {
+    static constexpr const char* names[] = {"array_f64", "f64_f64", "i64_i64"};
+    return names[fn.index()];
+}
+
+/**
+ * @brief `i64_i64`函数接受的参数范围,闭区间,默认不限制
+ */
+struct I64Domain {
+    std::int64_t min = std::numeric_limits<std::int64_t>::min();
+    std::int64_t max = std::numeric_limits<std::int64_t>::max();
+
+    bool contains(std::int64_t x) const noexcept { return min <= x && x <= max; }
+};
+
+struct NativeFunction {
+    std::string name;
+    NativeFn fn;
+    I64Domain domain{};
+};
+
+/**
+ * @brief 不可修改的完美哈希表
+ */
+class NativeTable {
+   public:
+    NativeTable() = default;
+
+    /**
+     * @param[functions]  函数,名字不能重复
+     * @exception <std::runtime_error> { 找不到无冲突的种子 }
+     */
+    explicit NativeTable(std::vector<NativeFunction> functions) : functions_(std::move(functions)) {
+        std::size_t size = std::bit_ceil(std::max<std::size_t>(functions_.size(), 1));
+        // 槽位数为函数数的1到8倍,每种大小尝试一批种子
+        for (std::size_t slots = size; slots <= size * 8; slots *= 2) {
+            for (std::uint64_t seed = 0; seed < 4096; ++seed) {
+                if (try_build(seed, slots)) {
+                    return;
+                }
+            }
+        }
+        throw std::runtime_error("cannot build a perfect hash for native functions");
+    }
+
+    /**
+     * @fn find
+     * @brief 按名字查找,没有时返回NULL
+     */
+    const NativeFunction* find(std::string_view name) const noexcept {
+        if (functions_.empty()) {
+            return nullptr;
+        }
+        std::int32_t index = slots_[hash(name, seed_) & mask_];
+        if (index < 0 || functions_[index].name != name) {
+            return nullptr;
+        }
+        return &functions_[index];
+    }
+
+    const std::vector<NativeFunction>& functions() const noexcept { return functions_; }
+
+   private:
+    /**
+     * @brief 带种子的FNV-1a,最后用splitmix64的混合函数打散,低位也足够均匀
+     */
+    static std::uint64_t hash(std::string_view key, std::uint64_t seed) noexcept {
+        std::uint64_t h = 0xcbf29ce484222325ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+        for (unsigned char c : key) {
+            h = (h ^ c) * 0x100000001b3ULL;
+        }
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    }
+
+    bool try_build(std::uint64_t seed, std::size_t slots) {
+        slots_.assign(slots, -1);
+        for (std::size_t i = 0; i < functions_.size(); ++i) {
+            auto& slot = slots_[hash(functions_[i].name, seed) & (slots - 1)];
+            if (slot >= 0) {
+                return false;
+            }
+            slot = static_cast<std::int32_t>(i);
+        }
+        seed_ = seed;
+        mask_ = slots - 1;
+        return true;
+    }
+
+    std::vector<NativeFunction> functions_;
+    std::vector<std::int32_t> slots_;
+    std::uint64_t seed_ = 0;
+    std::uint64_t mask_ = 0;
+};
+
+/**
+ * @brief 函数注册表,通过`native_registry()`访问单例
+ */
+class NativeRegistry {
+   public:
+    /**
+     * @fn add
+     * @brief 登记函数,同名的会被替换,`publish`之后才对查找可见
+     */
+    template <typename Fn>
+    void add(const char* name, Fn fn) {
+        add_function(NativeFunction{name, fn});
+    }
+
+    /**
+     * @fn add
+     * @brief 登记参数限定在`[min_arg, max_arg]`内的`i64_i64`函数,超出范围的调用由调用方拒绝
+     */
+    void add(const char* name, native_i64_i64 fn, std::int64_t min_arg, std::int64_t max_arg) {
+        add_function(NativeFunction{name, fn, I64Domain{min_arg, max_arg}});
+    }
+
+    /**
+     * @fn publish
+     * @brief 用目前登记的所有函数构造新表并替换旧表
+     * @exception <std::runtime_error> { 构造完美哈希失败 }
+     */
+    void publish() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        table_.store(std::make_shared<const NativeTable>(pending_));
+    }
+
+    /**
+     * @fn table
+     * @brief 当前的表,持有期间即使发布了新表也一直有效
+     */
+    std::shared_ptr<const NativeTable> table() const noexcept { return table_.load(); }
+
+    /**
+     * @fn find_array_f64
+     * @brief 查找`array_f64`签名的函数,没有或者签名不同时返回NULL
+     */
+    native_array_f64 find_array_f64(const char* name) const noexcept {
+        auto current = table();
+        auto function = current->find(name);
+        if (function == nullptr) {
+            return nullptr;
+        }
+        auto fn = std::get_if<native_array_f64>(&function->fn);
+        return fn == nullptr ? nullptr : *fn;
+    }
+
+    /**
+     * @fn names
+     * @brief 当前表中所有函数的名字
+     */
+    std::vector<std::string> names() const {
+        std::vector<std::string> result;
+        for (auto& function : table()->functions()) {
+            result.push_back(function.name);
+        }
+        return result;
+    }
+
+   private:
+    void add_function(NativeFunction function) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : pending_) {
+            if (entry.name == function.name) {
+                entry = std::move(function);
+                return;
+            }
+        }
+        pending_.push_back(std::move(function));
+    }
+
+    std::mutex mutex_;
+    std::vector<NativeFunction> pending_;
+    std::atomic<std::shared_ptr<const NativeTable>> table_{std::make_shared<const NativeTable>()};
+};
+
+namespace {
+
+/**
+ * @brief 本翻译单元的注册表,放在匿名命名空间中,每个`emb`版本各有一个
+ */
+inline NativeRegistry& native_registry() {
+    static NativeRegistry registry;
+    return registry;
+}
+
+}  // namespace
+
+#endif /* NATIVE_REGISTRY_HPP_ */
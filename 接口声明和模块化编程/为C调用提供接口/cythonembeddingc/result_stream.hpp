@@ -0,0 +1,164 @@
+/**
+ * @file result_stream.hpp
+ * @brief 脚本向http响应增量输出结果用的有界字节环形缓冲
+ *
+ * 单生产者单消费者:生产者是执行脚本的线程,通过`emb.emit`写入;消费者是crow的io线程,读出后以chunked编码发给客户端.
+ * 缓冲满时生产者等待(`emb.emit`在等待前释放GIL),客户端读得慢时脚本会被自然地拖慢,内存占用不超过容量.
+ *
+ * 由`emb.pyx`通过`cdef extern`使用,和`main.cpp`共享同一份定义.
+ * 当前线程的输出流`current_result_stream`是内部链接的,每个`emb`版本各有一份,原因见`native_registry.hpp`.
+ */
+#ifndef RESULT_STREAM_HPP_
+#define RESULT_STREAM_HPP_
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+class ResultStream {
+   public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief 写入的结果
+     */
+    enum WriteStatus {
+        WRITE_OK = 0,
+        WRITE_CLOSED = 1,   // 读端已关闭,客户端断开了连接
+        WRITE_TIMEOUT = 2,  // 等待空间时超过了截止时间
+    };
+
+    /**
+     * @param[capacity]  缓冲的字节数,向上取整为2的幂
+     * @param[deadline]  生产者等待空间的截止时间
+     */
+    ResultStream(std::size_t capacity, clock::time_point deadline)
+        : capacity_(std::bit_ceil(std::max<std::size_t>(capacity, 64))),
+          buffer_(new char[capacity_]),
+          deadline_(deadline) {}
+
+    ResultStream(const ResultStream&) = delete;
+    ResultStream& operator=(const ResultStream&) = delete;
+
+    /**
+     * @fn write
+     * @brief 写入`len`个字节,空间不够时等待消费者读出,不需要持有GIL
+     * @details 超过容量的数据分多次写入,中途失败时已写入的部分仍会被读出.
+     * @return WriteStatus
+     */
+    WriteStatus write(const char* data, std::size_t len) noexcept { return write_until(data, len, deadline_); }
+
+    /**
+     * @fn write_until
+     * @brief 同`write`,使用指定的截止时间
+     */
+    WriteStatus write_until(const char* data, std::size_t len, clock::time_point deadline) noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (len > 0) {
+            if (!not_full_.wait_until(lock, deadline, [this] { return reader_closed_ || tail_ - head_ < capacity_; })) {
+                return WRITE_TIMEOUT;
+            }
+            if (reader_closed_) {
+                return WRITE_CLOSED;
+            }
+            std::size_t n = std::min(len, capacity_ - (tail_ - head_));
+            copy_in(data, n);
+            tail_ += n;
+            data += n;
+            len -= n;
+            not_empty_.notify_one();
+        }
+        return WRITE_OK;
+    }
+
+    /**
+     * @fn close_writer
+     * @brief 生产者结束,读端读完剩余数据后得到EOF
+     */
+    void close_writer() noexcept {
+        std::lock_guard<std::mutex> lock(mutex_);
+        writer_closed_ = true;
+        not_empty_.notify_one();
+    }
+
+    /**
+     * @fn read
+     * @brief 等待数据并读出最多`max_len`个字节追加到`out`
+     * @return bool 之后是否还可能有数据,生产者已结束且缓冲读空时为false
+     */
+    bool read(std::string& out, std::size_t max_len) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return writer_closed_ || tail_ != head_; });
+        std::size_t n = std::min(max_len, tail_ - head_);
+        copy_out(out, n);
+        head_ += n;
+        not_full_.notify_one();
+        return !(writer_closed_ && tail_ == head_);
+    }
+
+    /**
+     * @fn close_reader
+     * @brief 消费者不再读取,等待中和之后的写入返回`WRITE_CLOSED`
+     */
+    void close_reader() noexcept {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reader_closed_ = true;
+        not_full_.notify_one();
+    }
+
+   private:
+    void copy_in(const char* data, std::size_t n) noexcept {
+        std::size_t pos = tail_ & (capacity_ - 1);
+        std::size_t first = std::min(n, capacity_ - pos);
+        std::memcpy(buffer_.get() + pos, data, first);
+        std::memcpy(buffer_.get(), data + first, n - first);
+    }
+
+    void copy_out(std::string& out, std::size_t n) {
+        std::size_t pos = head_ & (capacity_ - 1);
+        std::size_t first = std::min(n, capacity_ - pos);
+        out.append(buffer_.get() + pos, first);
+        out.append(buffer_.get(), n - first);
+    }
+
+    const std::size_t capacity_;
+    std::unique_ptr<char[]> buffer_;
+    const clock::time_point deadline_;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    // 只增不减的读写位置,差值为缓冲中的字节数
+    std::size_t head_ = 0;
+    std::size_t tail_ = 0;
+    bool writer_closed_ = false;
+    bool reader_closed_ = false;
+};
+
+namespace {
+
+thread_local ResultStream* current_stream = nullptr;
+
+/**
+ * @fn current_result_stream
+ * @brief 当前线程正在执行的脚本输出到的流,没有时为NULL
+ */
+inline ResultStream* current_result_stream() noexcept { return current_stream; }
+
+/**
+ * @fn exchange_result_stream
+ * @brief 把`stream`设为当前线程的输出流,返回原来的
+ * @details `emb`可能被热重载为另一个`.so`,每个版本有自己的一份,
+ * 宿主需要通过对应版本`EmbApi`中的`bind_result_stream`设置.
+ */
+inline ResultStream* exchange_result_stream(ResultStream* stream) noexcept { return std::exchange(current_stream, stream); }
+
+}  // namespace
+
+#endif /* RESULT_STREAM_HPP_ */
@@ -0,0 +1,22 @@
+import struct
+
+import numpy as np
+import requests as rq
+
+headers = {"Content-Type": "application/octet-stream"}
+x = np.random.rand(1_000_000)
+# /kernel持有GIL查找后在nogil下执行, /native全程不获取GIL
+for route in ("kernel", "native"):
+    for name in ("normalize", "l2norm"):
+        rs = rq.post(f"http://localhost:18080/{route}/{name}", data=x.tobytes(), headers=headers)
+        print(route, name, rs.status_code)
+        if rs.status_code == 200:
+            print(np.frombuffer(rs.content)[:5])
+
+print(rq.get("http://localhost:18080/native").json())
+rs = rq.post("http://localhost:18080/native/fib", data=struct.pack("q", 50), headers=headers)
+print("fib(50)", struct.unpack("q", rs.content)[0])
+# 超出int64的参数和负数直接返回400,不会执行
+for n in (93, -1):
+    rs = rq.post("http://localhost:18080/native/fib", data=struct.pack("q", n), headers=headers)
+    print(f"fib({n})", rs.status_code)
@@ -0,0 +1,31 @@
+import requests as rq
+
+# 先在脚本中`import emb`,热重载后的脚本再次`import emb`应该拿到新版本
+# 需要先按build.sh编译出`emb.v2.so`放在服务的工作目录下;
+# 再删掉emb.pyx中`sigmoid`的登记,重新cython后同样编译出`emb.v3.so`
+script = b"""
+import emb
+emb.set_numargs(7)
+"""
+rs = rq.post("http://localhost:18080/submit", files=[('script', ('before.py', script, 'application/python'))])
+print("before", rs.status_code, rs.json())
+
+rs = rq.post("http://localhost:18080/admin/reload/v2")
+print("reload", rs.status_code, rs.json())
+
+# 之前脚本的`emb`绑定不会留下;`numargs`由旧版本交接过来,宿主从新版本读出结果,应该是8
+script = b"""
+assert "emb" not in globals()
+import emb
+emb.set_numargs(emb.get_numargs() + 1)
+"""
+rs = rq.post("http://localhost:18080/submit", files=[('script', ('after.py', script, 'application/python'))])
+print("after", rs.status_code, rs.json() if rs.status_code == 200 else rs.text)
+
+
+# 每个版本有自己的注册表,v3中去掉的`sigmoid`不应该再出现
+rs = rq.post("http://localhost:18080/admin/reload/v3")
+print("reload", rs.status_code, rs.json())
+natives = rq.get("http://localhost:18080/native").json()
+print("natives", natives)
+assert "sigmoid" not in natives, natives
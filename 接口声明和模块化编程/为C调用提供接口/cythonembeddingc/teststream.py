@@ -0,0 +1,15 @@
+import requests as rq
+
+script = b"""
+import time
+import emb
+for i in range(5):
+    emb.emit({"step": i})
+    time.sleep(0.5)
+"""
+
+with rq.post("http://localhost:18080/submit/stream", files=[('script', ('stream.py', script, 'application/python'))], stream=True) as rs:
+    print(rs.status_code)
+    for line in rs.iter_lines():
+        if line:
+            print(line.decode())
@@ -0,0 +1,164 @@
+/**
+ * @file watchdog.hpp
+ * @brief 给执行中的python脚本设置截止时间,超时后在脚本所在的线程中抛出`TimeoutError`
+ *
+ * 后台线程定期检查登记的截止时间,发现超时后获取GIL,用`PyThreadState_SetAsyncExc`
+ * 向脚本所在的线程注入异常.解释器每执行一段字节码就会检查异步异常,因此纯python的死循环也能被打断;
+ * 阻塞在C扩展或者系统调用中的脚本要等它们返回后才会抛出.
+ * 脚本用`except`吞掉异常继续执行时,每次检查都会再注入一次,直到脚本结束.
+ *
+ * `Py_AddPendingCall`登记的回调只会在主线程执行,而脚本是在crow的请求线程中执行的,因此这里不用它.
+ */
+#ifndef WATCHDOG_HPP_
+#define WATCHDOG_HPP_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <mutex>
+#include <thread>
+
+class ScriptWatchdog {
+    struct Entry {
+        unsigned long thread_id;
+        std::chrono::steady_clock::time_point deadline;
+        bool timed_out = false;
+    };
+
+   public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief 一次登记,析构时注销,注销后不会再向该线程注入异常
+     */
+    class [[nodiscard]] Watch {
+       public:
+        Watch(Watch&& other) noexcept : owner_(std::exchange(other.owner_, nullptr)), id_(other.id_) {}
+        Watch(const Watch&) = delete;
+        Watch& operator=(const Watch&) = delete;
+        Watch& operator=(Watch&&) = delete;
+
+        /**
+         * @brief 需要持有GIL
+         */
+        ~Watch() {
+            if (owner_ != nullptr) {
+                owner_->unwatch(id_);
+            }
+        }
+
+        /**
+         * @brief 是否因为超时被注入了异常
+         */
+        bool timed_out() const {
+            std::lock_guard<std::mutex> lock(owner_->mutex_);
+            auto it = owner_->entries_.find(id_);
+            return it != owner_->entries_.end() && it->second.timed_out;
+        }
+
+       private:
+        friend class ScriptWatchdog;
+        Watch(ScriptWatchdog* owner, std::uint64_t id) noexcept : owner_(owner), id_(id) {}
+        ScriptWatchdog* owner_;
+        std::uint64_t id_;
+    };
+
+    /**
+     * @param[tick]  检查的间隔,也是超时判断的最大误差
+     */
+    explicit ScriptWatchdog(std::chrono::milliseconds tick = std::chrono::milliseconds(10))
+        : tick_(tick), thread_([this] { run(); }) {}
+
+    /**
+     * @brief 停止后台线程,必须在回收解释器之前,且在不持有GIL时析构
+     */
+    ~ScriptWatchdog() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+
+    ScriptWatchdog(const ScriptWatchdog&) = delete;
+    ScriptWatchdog& operator=(const ScriptWatchdog&) = delete;
+
+    /**
+     * @fn watch
+     * @brief 为当前线程登记截止时间,需要持有GIL
+     * @param[deadline]  截止时间,到期后当前线程中执行的python代码会抛出`TimeoutError`
+     */
+    Watch watch(clock::time_point deadline) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto id = next_id_++;
+        entries_.emplace(id, Entry{PyThread_get_thread_ident(), deadline});
+        return Watch(this, id);
+    }
+
+   private:
+    void unwatch(std::uint64_t id) {
+        unsigned long thread_id = 0;
+        bool timed_out = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(id);
+            thread_id = it->second.thread_id;
+            timed_out = it->second.timed_out;
+            entries_.erase(it);
+        }
+        // 注入发生在脚本结束之后时异常还没有被抛出,清掉它,避免落到这个线程之后执行的代码上.
+        // 注入和注销都在持有GIL时进行,注销之后后台线程不会再注入
+        if (timed_out) {
+            PyThreadState_SetAsyncExc(thread_id, NULL);
+        }
+    }
+
+    bool has_expired(clock::time_point now) const {
+        for (auto& [id, entry] : entries_) {
+            if (entry.deadline <= now) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            cv_.wait_for(lock, tick_);
+            if (stopping_ || !has_expired(clock::now())) {
+                continue;
+            }
+            // 获取GIL可能要等脚本让出,期间不能持有锁,否则脚本结束时注销会被阻塞
+            lock.unlock();
+            PyGILState_STATE gstate = PyGILState_Ensure();
+            lock.lock();
+            auto now = clock::now();
+            for (auto& [id, entry] : entries_) {
+                if (entry.deadline <= now) {
+                    PyThreadState_SetAsyncExc(entry.thread_id, PyExc_TimeoutError);
+                    entry.timed_out = true;
+                }
+            }
+            lock.unlock();
+            PyGILState_Release(gstate);
+            lock.lock();
+        }
+    }
+
+    std::chrono::milliseconds tick_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    std::uint64_t next_id_ = 0;
+    std::map<std::uint64_t, Entry> entries_;
+    std::thread thread_;
+};
+
+#endif /* WATCHDOG_HPP_ */
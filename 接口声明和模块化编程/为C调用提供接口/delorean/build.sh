@@ -1,3 +1,3 @@
 python -m build --wheel
 
-g++ -I /Users/mac/micromamba/envs/py3.10/include/python3.10 -I /Users/mac/WORKSPACE/GITHUB/BLOG/TutorialForCython/接口声明和模块化编程/为C调用提供接口/delorean/env/lib/python3.10/site-packages/delorean -L/Users/mac/micromamba/envs/py3.10/lib -lpython3.10 -o ccallcy -std=c++20 main.cpp
\ No newline at end of file
+g++ -I /Users/mac/micromamba/envs/py3.10/include/python3.10 -I ../pyembed -I /Users/mac/WORKSPACE/GITHUB/BLOG/TutorialForCython/接口声明和模块化编程/为C调用提供接口/delorean/env/lib/python3.10/site-packages/delorean -L/Users/mac/micromamba/envs/py3.10/lib -lpython3.10 -o ccallcy -std=c++20 main.cpp ../pyembed/pyembed.cpp
\ No newline at end of file
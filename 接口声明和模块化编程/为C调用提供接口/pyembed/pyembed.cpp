@@ -0,0 +1,240 @@
+#include "pyembed.hpp"
+#include <cstdio>
+
+namespace pyembed {
+
+namespace {
+
+/**
+ * @brief 相对路径以当前工作目录为基准转为绝对路径
+ */
+std::filesystem::path to_absolute(const std::filesystem::path& p) {
+    return p.is_relative() ? std::filesystem::absolute(p) : p;
+}
+
+void check_status(const PyStatus& status, const char* what) {
+    if (PyStatus_Exception(status)) {
+        std::string msg = std::string("Fatal error: ") + what;
+        if (status.err_msg != NULL) {
+            msg += std::string(": ") + status.err_msg;
+        }
+        throw EmbedError(msg);
+    }
+}
+
+/**
+ * @brief 管理`PyConfig`的生命周期
+ */
+struct ConfigHolder {
+    PyConfig config;
+    ~ConfigHolder() { PyConfig_Clear(&config); }
+};
+
+/**
+ * @brief 设置`PyConfig`中的字符串字段,按locale解码
+ */
+void set_path(PyConfig& config, wchar_t** field, const std::filesystem::path& p, const char* what) {
+    // 保留std::string直到解码完成,避免c_str()悬空
+    auto s = p.string();
+    check_status(PyConfig_SetBytesString(&config, field, s.c_str()), what);
+}
+
+bool interpreter_alive = false;
+
+}  // namespace
+
+ConfigBuilder::ConfigBuilder(const char* programname) {
+    if (programname == NULL) {
+        throw EmbedError("Fatal error: programname must set");
+    }
+    program_ = programname;
+}
+
+ConfigBuilder& ConfigBuilder::isolated(bool on) {
+    isolated_ = on;
+    return *this;
+}
+
+ConfigBuilder& ConfigBuilder::home(const std::filesystem::path& dir) {
+    home_ = to_absolute(dir);
+    return *this;
+}
+
+ConfigBuilder& ConfigBuilder::venv(const std::filesystem::path& dir) {
+    venv_ = to_absolute(dir);
+    return *this;
+}
+
+ConfigBuilder& ConfigBuilder::module_path(const std::filesystem::path& dir) {
+    module_paths_.push_back(to_absolute(dir));
+    return *this;
+}
+
+ConfigBuilder& ConfigBuilder::inittab(const char* name, InitFunc initfunc) {
+    inittabs_.emplace_back(name, initfunc);
+    return *this;
+}
+
+ConfigBuilder& ConfigBuilder::debug(bool on) {
+    debug_ = on;
+    return *this;
+}
+
+HandleCache::~HandleCache() {
+    if (Py_IsInitialized()) {
+        clear();
+    }
+}
+
+PyObject* HandleCache::module(const std::string& name) {
+    auto it = modules_.find(name);
+    if (it != modules_.end()) {
+        return it->second;
+    }
+    auto pModule = PyImport_ImportModule(name.c_str());
+    if (pModule == NULL) {
+        return NULL;
+    }
+    // 导入过程中可能释放过GIL,其他线程可能已经放入了同名模块
+    auto [pos, inserted] = modules_.try_emplace(name, pModule);
+    if (!inserted) {
+        Py_DECREF(pModule);
+    }
+    return pos->second;
+}
+
+PyObject* HandleCache::attr(const std::string& module_name, const std::string& attr_path) {
+    auto key = module_name + ":" + attr_path;
+    auto it = attrs_.find(key);
+    if (it != attrs_.end()) {
+        return it->second;
+    }
+    auto pModule = module(module_name);
+    if (pModule == NULL) {
+        return NULL;
+    }
+    // 按`.`逐级查找
+    Py_INCREF(pModule);
+    PyObject* pObj = pModule;
+    std::size_t start = 0;
+    while (start <= attr_path.size()) {
+        auto end = attr_path.find('.', start);
+        if (end == std::string::npos) {
+            end = attr_path.size();
+        }
+        auto name = attr_path.substr(start, end - start);
+        auto pNext = PyObject_GetAttrString(pObj, name.c_str());
+        Py_DECREF(pObj);
+        if (pNext == NULL) {
+            return NULL;
+        }
+        pObj = pNext;
+        start = end + 1;
+    }
+    auto [pos, inserted] = attrs_.try_emplace(key, pObj);
+    if (!inserted) {
+        Py_DECREF(pObj);
+    }
+    return pos->second;
+}
+
+void HandleCache::clear() noexcept {
+    for (auto& [key, value] : attrs_) {
+        Py_DECREF(value);
+    }
+    attrs_.clear();
+    for (auto& [key, value] : modules_) {
+        Py_DECREF(value);
+    }
+    modules_.clear();
+}
+
+Interpreter::Interpreter(const ConfigBuilder& builder) {
+    if (interpreter_alive) {
+        throw EmbedError("Fatal error: interpreter already initialized");
+    }
+    if (builder.isolated_ && !builder.home_) {
+        throw EmbedError("Fatal error: isolated config must set pyhomepath");
+    }
+    // 预设置
+    if (builder.isolated_) {
+        PyPreConfig preconfig;
+        PyPreConfig_InitIsolatedConfig(&preconfig);
+        preconfig.utf8_mode = 1;
+        check_status(Py_PreInitialize(&preconfig), "Py_PreInitialize get error");
+    }
+    // 基本设置
+    ConfigHolder holder;
+    auto& config = holder.config;
+    if (builder.isolated_) {
+        PyConfig_InitIsolatedConfig(&config);
+    } else {
+        PyConfig_InitPythonConfig(&config);
+    }
+    check_status(PyConfig_SetBytesString(&config, &config.program_name, builder.program_.c_str()),
+                 "InitPythonConfig set program_name get error");
+#if PY_VERSION_HEX >= 0x030B0000
+    // 不把程序所在目录自动加入sys.path,查找路径只由module_path决定
+    config.safe_path = 1;
+#endif
+    if (builder.home_) {
+        set_path(config, &config.home, *builder.home_, "InitPythonConfig set home get error");
+        if (builder.debug_) {
+            printf("use python_home %s \n", builder.home_->c_str());
+        }
+    }
+    if (builder.venv_) {
+        // 将可执行文件指向虚拟环境中的python,由解释器根据`pyvenv.cfg`推导prefix和site-packages,
+        // 标准库路径仍然来自基础环境
+        set_path(config, &config.executable, *builder.venv_ / "bin" / "python", "InitPythonConfig set executable get error");
+        if (builder.debug_) {
+            printf("use virtual environments %s \n", builder.venv_->c_str());
+        }
+    }
+    // 注册内置模块
+    for (const auto& [name, initfunc] : builder.inittabs_) {
+        if (PyImport_AppendInittab(name, initfunc) == -1) {
+            throw EmbedError(std::string("Fatal error: could not extend in-built modules table with ") + name);
+        }
+    }
+    // 初始化python解释器
+    check_status(Py_InitializeFromConfig(&config), "Py_InitializeFromConfig get error");
+    interpreter_alive = true;
+
+    // 设置python的sys.path用于查找模块,倒序插入到最前面以保持添加顺序
+    auto pPath = PySys_GetObject("path");  // 借用引用
+    for (auto it = builder.module_paths_.rbegin(); it != builder.module_paths_.rend(); ++it) {
+        auto dir = it->string();
+        auto pDir = PyUnicode_DecodeFSDefault(dir.c_str());
+        if (pDir == NULL || pPath == NULL || PyList_Insert(pPath, 0, pDir) < 0) {
+            Py_XDECREF(pDir);
+            PyErr_Print();
+            finalize();
+            throw EmbedError("Fatal error: cannot insert " + dir + " into sys.path");
+        }
+        Py_DECREF(pDir);
+        if (builder.debug_) {
+            printf("pymodule_dir %s \n", dir.c_str());
+        }
+    }
+    if (builder.debug_) {
+        PyRun_SimpleString("import sys;print(sys.path);print(sys.prefix)");
+    }
+}
+
+Interpreter::~Interpreter() { finalize(); }
+
+int Interpreter::finalize() noexcept {
+    if (finalized_ || !interpreter_alive) {
+        return 0;
+    }
+    finalized_ = true;
+    interpreter_alive = false;
+    handles_.clear();
+    if (Py_FinalizeEx() < 0) {
+        return 120;
+    }
+    return 0;
+}
+
+}  // namespace pyembed
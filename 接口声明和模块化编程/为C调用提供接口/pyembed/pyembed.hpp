@@ -0,0 +1,236 @@
+/**
+ * @file pyembed.hpp
+ * @brief 在C++程序中嵌入python解释器的公共工具
+ *
+ * 包括:
+ * + `ConfigBuilder`,构造解释器的初始化配置
+ * + `Interpreter`,RAII管理解释器的初始化和回收
+ * + `GilGuard`/`GilRelease`,RAII获取/释放GIL
+ * + `HandleCache`,缓存导入的模块和取到的属性,避免每次调用都重复查找
+ * + `PyRef`,持有`PyObject*`强引用的智能指针
+ *
+ * 通用的作用域守卫在同目录的`scope_guard.hpp`中.
+ */
+#ifndef PYEMBED_HPP_
+#define PYEMBED_HPP_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pyembed {
+
+/**
+ * @brief 嵌入解释器过程中的异常
+ */
+class EmbedError : public std::runtime_error {
+   public:
+    using std::runtime_error::runtime_error;
+};
+
+// 内置模块的初始化函数,即cython生成的`PyInit_<模块名>`
+using InitFunc = PyObject* (*)(void);
+
+/**
+ * @brief 解释器初始化配置的构造器
+ * @details 路径参数为相对路径时以当前工作目录为基准转为绝对路径.
+ */
+class ConfigBuilder {
+   public:
+    /**
+     * @param[programname]  应用名,一般传`argv[0]`
+     */
+    explicit ConfigBuilder(const char* programname);
+
+    /**
+     * @brief 使用隔离配置初始化,不读取环境变量和用户目录.隔离模式下必须设置`home`
+     */
+    ConfigBuilder& isolated(bool on = true);
+
+    /**
+     * @brief 设置python_home,即标准库所在的前缀目录
+     */
+    ConfigBuilder& home(const std::filesystem::path& dir);
+
+    /**
+     * @brief 使用虚拟环境,`dir`为虚拟环境的根目录(其中有`pyvenv.cfg`)
+     */
+    ConfigBuilder& venv(const std::filesystem::path& dir);
+
+    /**
+     * @brief 增加模块查找路径,初始化后按添加顺序插入到`sys.path`的最前面
+     */
+    ConfigBuilder& module_path(const std::filesystem::path& dir);
+
+    /**
+     * @brief 注册内置模块,在解释器初始化前调用`PyImport_AppendInittab`
+     * @param[name]  模块名,需要在解释器生命周期内有效,一般传字符串字面量
+     * @param[initfunc]  模块初始化函数
+     */
+    ConfigBuilder& inittab(const char* name, InitFunc initfunc);
+
+    /**
+     * @brief 是否打印debug用的文本
+     */
+    ConfigBuilder& debug(bool on = true);
+
+   private:
+    friend class Interpreter;
+    std::string program_;
+    bool isolated_ = false;
+    bool debug_ = false;
+    std::optional<std::filesystem::path> home_;
+    std::optional<std::filesystem::path> venv_;
+    std::vector<std::filesystem::path> module_paths_;
+    std::vector<std::pair<const char*, InitFunc>> inittabs_;
+};
+
+/**
+ * @brief 导入的模块和属性的缓存
+ * @details 返回的都是借用引用,由缓存持有,在`clear()`或解释器回收前一直有效.
+ * 所有方法都必须在持有GIL时调用.
+ */
+class HandleCache {
+   public:
+    HandleCache() = default;
+    HandleCache(const HandleCache&) = delete;
+    HandleCache& operator=(const HandleCache&) = delete;
+    ~HandleCache();
+
+    /**
+     * @brief 获取模块,第一次访问时导入
+     * @return PyObject* 借用引用,失败时返回NULL并设置python异常
+     */
+    PyObject* module(const std::string& name);
+
+    /**
+     * @brief 获取模块中的属性,第一次访问时查找
+     * @param[module_name]  模块名
+     * @param[attr_path]  属性路径,可以用`.`分隔,比如`Vector.new`
+     * @return PyObject* 借用引用,失败时返回NULL并设置python异常
+     */
+    PyObject* attr(const std::string& module_name, const std::string& attr_path);
+
+    /**
+     * @brief 释放所有缓存的对象
+     */
+    void clear() noexcept;
+
+   private:
+    std::unordered_map<std::string, PyObject*> modules_;
+    std::unordered_map<std::string, PyObject*> attrs_;
+};
+
+/**
+ * @brief python解释器,构造时初始化,析构时回收
+ * @details 一个进程同一时间只能有一个`Interpreter`.构造完成后当前线程持有GIL.
+ */
+class Interpreter {
+   public:
+    /**
+     * @exception <EmbedError> { 初始化失败 }
+     */
+    explicit Interpreter(const ConfigBuilder& builder);
+    ~Interpreter();
+    Interpreter(const Interpreter&) = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
+
+    HandleCache& handles() noexcept { return handles_; }
+
+    /**
+     * @brief 提前回收解释器,需要在持有GIL的线程调用
+     * @return int 成功为0,失败为120
+     */
+    int finalize() noexcept;
+
+   private:
+    HandleCache handles_;
+    bool finalized_ = false;
+};
+
+/**
+ * @brief 持有一个`PyObject*`强引用的智能指针,只能移动不能复制
+ * @details 析构时`Py_XDECREF`,全部内联,和手写`Py_DECREF`相比只多一次判空.
+ * 析构和赋值都需要持有GIL.
+ */
+class PyRef {
+   public:
+    PyRef() noexcept = default;
+
+    /**
+     * @brief 接管一个新引用,比如`PyObject_Call`的返回值,可以为NULL
+     */
+    explicit PyRef(PyObject* obj) noexcept : obj_(obj) {}
+
+    /**
+     * @brief 从借用引用构造,引用计数加1
+     */
+    static PyRef borrow(PyObject* obj) noexcept {
+        Py_XINCREF(obj);
+        return PyRef(obj);
+    }
+
+    PyRef(PyRef&& other) noexcept : obj_(std::exchange(other.obj_, nullptr)) {}
+
+    PyRef& operator=(PyRef&& other) noexcept {
+        // 先换上新对象再释放旧对象,旧对象的`__del__`看到的是已经更新的状态
+        PyObject* old = std::exchange(obj_, std::exchange(other.obj_, nullptr));
+        Py_XDECREF(old);
+        return *this;
+    }
+
+    ~PyRef() { Py_XDECREF(obj_); }
+
+    PyRef(const PyRef&) = delete;
+    PyRef& operator=(const PyRef&) = delete;
+
+    PyObject* get() const noexcept { return obj_; }
+
+    /**
+     * @brief 交出所有权,用于把引用传给会"偷走"引用的API,比如`PyTuple_SET_ITEM`
+     */
+    [[nodiscard]] PyObject* release() noexcept { return std::exchange(obj_, nullptr); }
+
+    explicit operator bool() const noexcept { return obj_ != nullptr; }
+
+   private:
+    PyObject* obj_ = nullptr;
+};
+
+/**
+ * @brief 作用域内持有GIL,可以在任意线程使用
+ */
+class GilGuard {
+   public:
+    GilGuard() noexcept : state_(PyGILState_Ensure()) {}
+    ~GilGuard() { PyGILState_Release(state_); }
+    GilGuard(const GilGuard&) = delete;
+    GilGuard& operator=(const GilGuard&) = delete;
+
+   private:
+    PyGILState_STATE state_;
+};
+
+/**
+ * @brief 作用域内释放当前线程持有的GIL,用于执行不访问python对象的耗时逻辑
+ */
+class GilRelease {
+   public:
+    GilRelease() noexcept : save_(PyEval_SaveThread()) {}
+    ~GilRelease() { PyEval_RestoreThread(save_); }
+    GilRelease(const GilRelease&) = delete;
+    GilRelease& operator=(const GilRelease&) = delete;
+
+   private:
+    PyThreadState* save_;
+};
+
+}  // namespace pyembed
+
+#endif /* PYEMBED_HPP_ */
@@ -0,0 +1,78 @@
+/**
+ * @file scope_guard.hpp
+ * @brief 离开作用域时执行回调的RAII守卫
+ *
+ * 回调直接存放在守卫对象中,不经过`std::function`,没有堆分配也没有间接调用,
+ * 开启优化后析构只剩一次`active_`判断加上回调本身.
+ * 回调必须无参数,返回`void`且声明为`noexcept`,否则编译期报错,
+ * 避免在析构中抛出异常导致`std::terminate`.
+ *
+ * 用法:
+ * ```C++
+ * auto guard = sg::make_scope_guard([&]() noexcept { Py_XDECREF(obj); });
+ * guard.dismiss();  // 不再执行回调
+ * ```
+ */
+#ifndef SCOPE_GUARD_HPP_
+#define SCOPE_GUARD_HPP_
+
+#include <concepts>
+#include <type_traits>
+#include <utility>
+
+namespace sg {
+
+/**
+ * @brief 可以作为守卫回调的类型
+ */
+template <typename F>
+concept scope_guard_callback = std::is_nothrow_invocable_v<F&> && std::same_as<std::invoke_result_t<F&>, void> &&
+                               std::is_nothrow_destructible_v<F>;
+
+/**
+ * @brief 析构时执行回调的守卫,可以移动不能复制
+ */
+template <scope_guard_callback F>
+class [[nodiscard]] scope_guard final {
+   public:
+    explicit scope_guard(F callback) noexcept(std::is_nothrow_move_constructible_v<F>) : callback_(std::move(callback)) {}
+
+    scope_guard(scope_guard&& other) noexcept(std::is_nothrow_move_constructible_v<F>)
+        : callback_(std::move(other.callback_)), active_(std::exchange(other.active_, false)) {}
+
+    ~scope_guard() {
+        if (active_) {
+            callback_();
+        }
+    }
+
+    scope_guard() = delete;
+    scope_guard(const scope_guard&) = delete;
+    scope_guard& operator=(const scope_guard&) = delete;
+    scope_guard& operator=(scope_guard&&) = delete;
+
+    /**
+     * @fn dismiss
+     * @brief 取消守卫,析构时不再执行回调
+     */
+    void dismiss() noexcept { active_ = false; }
+
+   private:
+    [[no_unique_address]] F callback_;
+    bool active_ = true;
+};
+
+/**
+ * @fn make_scope_guard
+ * @brief 构造守卫,回调按值保存
+ * @param[callback]  离开作用域时执行的回调
+ */
+template <typename F>
+[[nodiscard]] scope_guard<std::decay_t<F>> make_scope_guard(F&& callback) noexcept(
+    std::is_nothrow_constructible_v<std::decay_t<F>, F&&>) {
+    return scope_guard<std::decay_t<F>>(std::forward<F>(callback));
+}
+
+}  // namespace sg
+
+#endif /* SCOPE_GUARD_HPP_ */
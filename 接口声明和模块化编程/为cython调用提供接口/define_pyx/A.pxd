@@ -1,3 +1,6 @@
+cimport cython
+from libc.stdint cimport uint32_t, int64_t
+
 ctypedef unsigned int uint_t
 
 cdef int GLOBAL_VAL
@@ -6,10 +9,19 @@ cdef uint_t mycfunc(uint_t x, uint_t y=*)
 
 cpdef int mycpfunc(int x, int y=*)
 
+# `mycfunc`和`mycpfunc`的数组版本,返回第一个溢出的位置,没有溢出或不检查时返回-1
+cdef Py_ssize_t mycfunc_kernel(const uint32_t[::1] xs, uint32_t y, uint32_t[::1] out, bint check) noexcept nogil
+cdef Py_ssize_t mycpfunc_kernel(const int64_t[::1] xs, int64_t y, int64_t[::1] out, bint check) noexcept nogil
+
 cdef inline int int_min(int a, int b):
     return b if b < a else a
 
-cdef double _helper(double a)
+cdef inline double _helper(double a) noexcept nogil:
+    return a + 1
+
+# `A.bar`的计算部分,没有异常检查也不需要GIL,调用方可以直接内联
+cdef inline double bar_kernel(double x) noexcept nogil:
+    return x * x + _helper(1.0)
 
 
 cdef class A:
@@ -17,3 +29,11 @@ cdef class A:
     cdef int b
     cdef double foo(self,double x)
     cpdef double bar(self, double x)
+
+
+# 不能再被继承.`bar`定义在`A.pyx`中,其他模块通过`FinalA`调用它时仍然要查虚表,
+# 因此在声明文件中提供内联的`bar_final`,cimport的模块可以直接调用,不查虚表也不检查python层的重写
+@cython.final
+cdef class FinalA(A):
+    cdef inline double bar_final(self, double x) noexcept nogil:
+        return bar_kernel(x)
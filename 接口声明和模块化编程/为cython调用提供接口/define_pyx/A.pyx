@@ -1,8 +1,19 @@
 # cython: embedsignature=True
 # cython: embedsignature.format=python
+cimport cython
+from libc.stdint cimport uint32_t, int64_t, uint64_t, UINT32_MAX, INT64_MIN, INT64_MAX
+
+import numpy as np
 
 GLOBAL_VAL = 100
 
+cdef extern from *:
+    ctypedef long long int128_t "__int128"
+
+# 检查溢出时按块累积溢出标记,块内没有分支可以向量化,发现溢出后再逐个查找第一个溢出的位置
+cdef enum:
+    OVERFLOW_BLOCK = 256
+
 cdef uint_t mycfunc(uint_t x, uint_t y=2):
     cdef uint_t a
     a = x-y
@@ -13,6 +24,128 @@ cpdef int mycpfunc(int x, int y=2):
     a = x+y
     return a + x * y
 
+# 只检查最终结果:中间结果超出范围而最终结果能放下时(比如`x=1, y=2`时的`x - y`)不算溢出.
+# 在更宽的类型中计算整个表达式,两个uint32的乘积放得进uint64,两个int64的乘积放得进int128
+
+cdef inline bint mycfunc_checked(uint32_t x, uint32_t y, uint32_t* out) noexcept nogil:
+    # x * y + x最大为2**64 - 2**32,不会超出uint64
+    cdef uint64_t t = <uint64_t>x * y + x
+    out[0] = <uint32_t>(t - y)
+    return (t < y) | (t - y > UINT32_MAX)
+
+
+cdef inline bint mycpfunc_checked(int64_t x, int64_t y, int64_t* out) noexcept nogil:
+    cdef int128_t t = <int128_t>x * y + x + y
+    out[0] = <int64_t>t
+    return (t < INT64_MIN) | (t > INT64_MAX)
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef Py_ssize_t mycfunc_kernel(const uint32_t[::1] xs, uint32_t y, uint32_t[::1] out, bint check) noexcept nogil:
+    cdef Py_ssize_t n = xs.shape[0]
+    cdef Py_ssize_t start, stop, i
+    cdef int flag
+    if not check:
+        for i in range(n):
+            out[i] = (xs[i] - y) + xs[i] * y
+        return -1
+    start = 0
+    while start < n:
+        stop = min(start + OVERFLOW_BLOCK, n)
+        flag = 0
+        for i in range(start, stop):
+            flag |= mycfunc_checked(xs[i], y, &out[i])
+        if flag:
+            for i in range(start, stop):
+                if mycfunc_checked(xs[i], y, &out[i]):
+                    return i
+        start = stop
+    return -1
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef Py_ssize_t mycpfunc_kernel(const int64_t[::1] xs, int64_t y, int64_t[::1] out, bint check) noexcept nogil:
+    cdef Py_ssize_t n = xs.shape[0]
+    cdef Py_ssize_t start, stop, i
+    cdef int flag
+    if not check:
+        # 有符号整数溢出是未定义行为,按无符号计算得到确定的回绕结果
+        for i in range(n):
+            out[i] = <int64_t>(<uint64_t>xs[i] + <uint64_t>y + <uint64_t>xs[i] * <uint64_t>y)
+        return -1
+    start = 0
+    while start < n:
+        stop = min(start + OVERFLOW_BLOCK, n)
+        flag = 0
+        for i in range(start, stop):
+            flag |= mycpfunc_checked(xs[i], y, &out[i])
+        if flag:
+            for i in range(start, stop):
+                if mycpfunc_checked(xs[i], y, &out[i]):
+                    return i
+        start = stop
+    return -1
+
+
+cdef _raise_overflow(str name, Py_ssize_t index):
+    err = OverflowError(f"{name} overflows at index {index}")
+    err.index = index
+    raise err
+
+
+def mycfunc_array(const uint32_t[::1] xs, uint32_t y=2, uint32_t[::1] out=None, bint check_overflow=False):
+    """对uint32数组的每个元素计算`mycfunc(x, y)`,结果写入out并返回.
+
+    默认和`mycfunc`一样按模2**32回绕.`check_overflow`为真时遇到第一个溢出的元素就抛出`OverflowError`,
+    其`index`属性为该元素的位置,此时out中只有该位置之前的结果有效.
+    只有最终结果超出uint32才算溢出,中间结果`x - y`为负不算:
+
+    >>> mycfunc_array(np.array([1, 3], dtype=np.uint32), 2, check_overflow=True)
+    array([1, 7], dtype=uint32)
+    >>> mycfunc_array(np.array([0], dtype=np.uint32), 2, check_overflow=True)
+    Traceback (most recent call last):
+        ...
+    OverflowError: mycfunc overflows at index 0
+    """
+    cdef Py_ssize_t index
+    if out is None:
+        out = np.empty(xs.shape[0], dtype=np.uint32)
+    elif out.shape[0] != xs.shape[0]:
+        raise ValueError("out must have the same length as xs")
+    with nogil:
+        index = mycfunc_kernel(xs, y, out, check_overflow)
+    if index >= 0:
+        _raise_overflow("mycfunc", index)
+    return out.base
+
+
+def mycpfunc_array(const int64_t[::1] xs, int64_t y=2, int64_t[::1] out=None, bint check_overflow=False):
+    """对int64数组的每个元素计算`mycpfunc(x, y)`,结果写入out并返回.
+
+    默认溢出时按模2**64回绕.`check_overflow`为真时遇到第一个溢出的元素就抛出`OverflowError`,
+    其`index`属性为该元素的位置,此时out中只有该位置之前的结果有效.
+    只有最终结果超出int64才算溢出:
+
+    >>> mycpfunc_array(np.array([-1], dtype=np.int64), -2**63, check_overflow=True)
+    array([-1])
+    >>> mycpfunc_array(np.array([2**62], dtype=np.int64), 1, check_overflow=True)
+    Traceback (most recent call last):
+        ...
+    OverflowError: mycpfunc overflows at index 0
+    """
+    cdef Py_ssize_t index
+    if out is None:
+        out = np.empty(xs.shape[0], dtype=np.int64)
+    elif out.shape[0] != xs.shape[0]:
+        raise ValueError("out must have the same length as xs")
+    with nogil:
+        index = mycpfunc_kernel(xs, y, out, check_overflow)
+    if index >= 0:
+        _raise_overflow("mycpfunc", index)
+    return out.base
+
 def mypfuncstatic(int x, int y):
     return x*y
 
@@ -20,11 +153,6 @@ def mypfunc(x:int, y: int)->int:
     return 2*x*y
 
 
-cdef double _helper(double a):
-    return a + 1
-
-
-
 cdef class A:
     def __init__(self, b:int = 0):
         self.a = 3
@@ -34,7 +162,26 @@ cdef class A:
         return x + _helper(1.0)
     
     cpdef double bar(self, double x):
-        return x**2 + _helper(1.0)
+        return bar_kernel(x)
 
     def foobar(self,x:float)->float:
-        return x**2 + _helper(1.0)
\ No newline at end of file
+        return bar_kernel(x)
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def bar_many(self, double[:] xs, double[:] out):
+        """对xs中的每个元素计算`bar`写入out,循环中释放GIL.
+
+        直接使用`bar_kernel`,子类重写的`bar`不会生效.
+        """
+        cdef Py_ssize_t i
+        if out.shape[0] != xs.shape[0]:
+            raise ValueError("out must have the same length as xs")
+        with nogil:
+            for i in range(xs.shape[0]):
+                out[i] = bar_kernel(xs[i])
+
+
+@cython.final
+cdef class FinalA(A):
+    pass
\ No newline at end of file
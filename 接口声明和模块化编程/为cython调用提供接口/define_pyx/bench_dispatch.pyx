@@ -0,0 +1,87 @@
+# cython: language_level=3
+"""对比`A.bar`的几种调用方式调用10^7次的耗时.
+
++ `cpdef`,通过`A`类型的变量调用,经过虚表并检查python层是否重写了`bar`
++ `final`,通过`FinalA`类型的变量调用,直接调用C函数
++ `inline`,直接调用`bar_kernel`,可以被编译器内联
++ `bar_many`,一次调用处理整个数组
++ `python`,在python层调用`bar`,作为参照只调用10^6次
+
+用法:
+    sh build.sh && python -c "import bench_dispatch; bench_dispatch.main()"
+"""
+cimport cython
+from time import perf_counter
+
+import numpy as np
+
+from A cimport A, FinalA, bar_kernel
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef double run_cpdef(A a, const double[:] xs) noexcept:
+    cdef double total = 0
+    cdef Py_ssize_t i
+    for i in range(xs.shape[0]):
+        total += a.bar(xs[i])
+    return total
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef double run_final(FinalA a, const double[:] xs) noexcept:
+    cdef double total = 0
+    cdef Py_ssize_t i
+    for i in range(xs.shape[0]):
+        total += a.bar_final(xs[i])
+    return total
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef double run_inline(const double[:] xs) noexcept nogil:
+    cdef double total = 0
+    cdef Py_ssize_t i
+    for i in range(xs.shape[0]):
+        total += bar_kernel(xs[i])
+    return total
+
+
+def main(Py_ssize_t n=10_000_000):
+    xs = np.random.default_rng(0).random(n)
+    out = np.empty(n)
+    out.fill(0.0)  # 先触发缺页,避免算进bar_many的耗时
+    a = A()
+    fa = FinalA()
+    cases = {}
+
+    start = perf_counter()
+    expected = run_cpdef(a, xs)
+    cases["cpdef"] = (perf_counter() - start, n)
+
+    start = perf_counter()
+    total = run_final(fa, xs)
+    cases["final"] = (perf_counter() - start, n)
+    assert total == expected
+
+    start = perf_counter()
+    total = run_inline(xs)
+    cases["inline"] = (perf_counter() - start, n)
+    assert total == expected
+
+    start = perf_counter()
+    a.bar_many(xs, out)
+    cases["bar_many"] = (perf_counter() - start, n)
+
+    m = n // 10
+    bar = (<object>a).bar
+    start = perf_counter()
+    for x in xs[:m].tolist():
+        bar(x)
+    cases["python"] = (perf_counter() - start, m)
+
+    base = cases["cpdef"][0] / cases["cpdef"][1]
+    for name, (cost, calls) in cases.items():
+        per_call = cost / calls
+        print(f"{name:<10}{calls:>10} calls {cost * 1000:>10.2f}ms {per_call * 1e9:>8.2f}ns/call  (x{base / per_call:.2f})")
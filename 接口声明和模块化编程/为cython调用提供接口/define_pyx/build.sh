@@ -1 +1,2 @@
-cythonize -i --3 A.pyx
\ No newline at end of file
+cythonize -i --3 A.pyx
+cythonize -i --3 bench_dispatch.pyx
@@ -0,0 +1,36 @@
+"""对比`release`配置下使用完整API和Limited API编译的`mymath`各个函数的耗时.
+
+每个函数只涉及一个模块,可以按结果决定哪些模块用Limited API发布
+(通过环境变量`MYMATH_LIMITED_API`按模块指定).
+
+用法:
+    python bench_limited_api.py
+"""
+import sys
+import tempfile
+from pathlib import Path
+
+from bench_profiles import build_and_run
+
+MODULE_OF = {
+    "normalize": "mymath.normalize",
+    "l2norm": "mymath.inner.l2norm",
+    "median_along_axis0": "mymath.median_along_axis0",
+}
+
+
+def main() -> None:
+    results = {}
+    for label, limited_api in (("full", ""), ("limited", "all")):
+        with tempfile.TemporaryDirectory(prefix=f"mymath-{label}-") as tmp:
+            print(f"building {label} api", file=sys.stderr)
+            results[label] = build_and_run("release", Path(tmp), limited_api)
+    full, limited = results["full"], results["limited"]
+    print(f"{'function':<26}{'module':<24}{'full api':>12}{'limited':>12}{'ratio':>8}")
+    for name in full:
+        module = MODULE_OF[name.split("[")[0]]
+        print(f"{name:<26}{module:<24}{full[name] * 1000:>10.2f}ms{limited[name] * 1000:>10.2f}ms{limited[name] / full[name]:>7.2f}x")
+
+
+if __name__ == "__main__":
+    main()
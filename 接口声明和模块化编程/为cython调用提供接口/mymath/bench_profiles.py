@@ -0,0 +1,104 @@
+"""对比`release`和`checked`两种编译配置下的耗时.
+
+`mymath`的数值内核在C++头文件中,转译指令只影响包装层,这几项主要反映编译参数和调用开销的差别.
+转译指令(`boundscheck`,`wraparound`,`cdivision`等)真正起作用的是cython代码中的下标循环,
+因此在构造时额外加入只用于计时的模块`mymath/_bench_loops.pyx`(`LOOPS_MODULE`),和`mymath`用同样的配置编译.
+
+两种配置分别在临时目录中构造,互不影响当前目录中已经编译好的模块.
+
+用法:
+    python bench_profiles.py
+"""
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+
+HERE = Path(__file__).resolve().parent
+
+# 纯cython的下标循环,每次访问都受`boundscheck`/`wraparound`影响,除法受`cdivision`影响
+LOOPS_MODULE = """
+def windowed_mean(const double[:] x, Py_ssize_t width, double[:] out):
+    cdef Py_ssize_t n = x.shape[0] - width + 1
+    cdef Py_ssize_t i, j
+    cdef double total
+    if width <= 0 or n <= 0 or out.shape[0] < n:
+        raise ValueError("invalid window")
+    for i in range(n):
+        total = 0
+        for j in range(width):
+            total += x[i + j]
+        out[i] = total / width
+    return n
+"""
+
+WORKLOAD = """
+import json
+import time
+
+import numpy as np
+
+import mymath
+from mymath._bench_loops import windowed_mean
+
+rng = np.random.default_rng(0)
+vector = rng.random(2_000_000)
+matrix = rng.random((501, 2_000))
+small = rng.random(64)
+small_matrix = rng.random((11, 8))
+window_out = np.empty_like(vector)
+# (函数, 参数, 重复次数, 每次计时内的调用次数),小数组主要衡量调用和参数转换的开销
+cases = {
+    "normalize": (mymath.normalize, vector, 20, 1),
+    "l2norm": (mymath.l2norm, vector, 20, 1),
+    "median_along_axis0": (mymath.median_along_axis0, matrix, 10, 1),
+    "normalize[64]": (mymath.normalize, small, 5, 10_000),
+    "l2norm[64]": (mymath.l2norm, small, 5, 10_000),
+    "median_along_axis0[11x8]": (mymath.median_along_axis0, small_matrix, 5, 10_000),
+    "windowed_mean[w=8]": (lambda x: windowed_mean(x, 8, window_out), vector, 10, 1),
+}
+result = {}
+for name, (func, arg, repeat, calls) in cases.items():
+    best = float("inf")
+    for _ in range(repeat):
+        start = time.perf_counter()
+        for _ in range(calls):
+            func(arg)
+        best = min(best, time.perf_counter() - start)
+    result[name] = best
+print(json.dumps(result))
+"""
+
+
+def build_and_run(profile: str, workdir: Path, limited_api: str = "") -> dict[str, float]:
+    """在`workdir`中按配置构造`mymath`并执行计时,`limited_api`和环境变量`MYMATH_LIMITED_API`的格式相同."""
+    shutil.copytree(HERE / "mymath", workdir / "mymath", ignore=shutil.ignore_patterns("*.so", "*.c", "*.cpp"))
+    shutil.copytree(HERE / "inc", workdir / "inc")
+    (workdir / "mymath" / "_bench_loops.pyx").write_text(LOOPS_MODULE)
+    for name in ("build_profiles.py", "setup.py"):
+        shutil.copy(HERE / name, workdir)
+    env = dict(os.environ, MYMATH_PROFILE=profile, MYMATH_LIMITED_API=limited_api)
+    subprocess.run([sys.executable, "setup.py", "-q", "build_ext", "--inplace", "--force"],
+                   cwd=workdir, env=env, check=True, capture_output=True)
+    out = subprocess.run([sys.executable, "-c", WORKLOAD], cwd=workdir, check=True, capture_output=True, text=True)
+    return json.loads(out.stdout.splitlines()[-1])
+
+
+def main() -> None:
+    results = {}
+    for profile in ("release", "checked"):
+        with tempfile.TemporaryDirectory(prefix=f"mymath-{profile}-") as tmp:
+            print(f"building {profile}", file=sys.stderr)
+            results[profile] = build_and_run(profile, Path(tmp))
+    release, checked = results["release"], results["checked"]
+    print(f"{'function':<26}{'checked':>12}{'release':>12}{'speedup':>10}")
+    for name in release:
+        print(f"{name:<26}{checked[name] * 1000:>10.2f}ms{release[name] * 1000:>10.2f}ms{checked[name] / release[name]:>9.2f}x")
+
+
+if __name__ == "__main__":
+    main()
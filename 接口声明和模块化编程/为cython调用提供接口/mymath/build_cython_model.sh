@@ -1,3 +1,3 @@
-cythonize -i --3 mymath
+python setup.py build_ext --inplace --force
 cythonize -i --3 cythoncallmymath.pyx
 # cythonize -i --3 callmymath.py
\ No newline at end of file
@@ -0,0 +1,76 @@
+"""`mymath`的编译配置.
+
+转译指令和编译参数集中在这里,`.pyx`文件中不再逐个函数地关闭检查:
+
++ `release`,关闭所有运行时检查,`-O3`,用于部署,打包和性能测试
++ `native`,同`release`,再加上`-march=native`,只用于在本机编译本机使用,编译出的模块在其他CPU上可能因为非法指令崩溃
++ `checked`,打开所有运行时检查,`-O1 -g`,用于测试,越界,None和除零都会抛出python异常
+
+`.pyx`头部的`# distutils:`设置(如`-fopenmp`,`language=c++`)仍然有效,这里的编译参数追加在其后.
+
+两种配置都可以按模块打开Limited API(`Py_LIMITED_API`和`CYTHON_LIMITED_API`),
+编译出的`abi3`动态链接库可以在3.11及之后的各个python版本中使用,不需要为每个小版本重新转译和编译.
+`abi3`模块就是为了分发给其他机器,因此不能和`native`配置一起使用.
+3.11起buffer协议才进入Limited API,memoryview依赖它,因此最低版本定为3.11.
+"""
+from typing import Iterable
+
+LIMITED_API_VERSION = "0x030B0000"
+LIMITED_API_TAG = "cp311"
+
+RELEASE_DIRECTIVES = {
+    "language_level": 3,
+    "boundscheck": False,
+    "wraparound": False,
+    "cdivision": True,
+    "initializedcheck": False,
+    "nonecheck": False,
+}
+
+PROFILES = {
+    "release": {
+        "directives": RELEASE_DIRECTIVES,
+        "compile_args": ["-O3"],
+    },
+    "native": {
+        "directives": RELEASE_DIRECTIVES,
+        "compile_args": ["-O3", "-march=native"],
+    },
+    "checked": {
+        "directives": {
+            "language_level": 3,
+            "boundscheck": True,
+            "wraparound": True,
+            "cdivision": False,
+            "initializedcheck": True,
+            "nonecheck": True,
+        },
+        "compile_args": ["-O1", "-g"],
+    },
+}
+
+
+def extensions(profile: str = "release", sources: str = "mymath/**/*.pyx", limited_api: Iterable[str] = ()) -> list:
+    """按配置转译`sources`,返回可以交给`setup(ext_modules=...)`的扩展列表.
+
+    `limited_api`为使用Limited API编译的模块名(如`mymath.normalize`),`all`表示全部模块.
+    """
+    from Cython.Build import cythonize
+
+    if profile not in PROFILES:
+        raise ValueError(f"unknown profile {profile!r}, expected one of {', '.join(PROFILES)}")
+    config = PROFILES[profile]
+    limited_api = set(limited_api)
+    if limited_api and "-march=native" in config["compile_args"]:
+        raise ValueError(f"profile {profile!r} targets the build machine's CPU and cannot be used for Limited API modules")
+    # 转译指令不参与cython的依赖检查,切换配置时必须强制重新转译
+    exts = cythonize(sources, compiler_directives=config["directives"], force=True, quiet=True)
+    for ext in exts:
+        ext.extra_compile_args = list(ext.extra_compile_args) + config["compile_args"]
+        if "all" in limited_api or ext.name in limited_api:
+            ext.define_macros = list(ext.define_macros) + [
+                ("Py_LIMITED_API", LIMITED_API_VERSION),
+                ("CYTHON_LIMITED_API", "1"),
+            ]
+            ext.py_limited_api = True
+    return exts
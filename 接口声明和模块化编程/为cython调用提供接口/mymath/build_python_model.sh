@@ -1 +1 @@
-cythonize -i --3 mymath/**/*.pyx
+python setup.py build_ext --inplace --force
@@ -0,0 +1,106 @@
+/**
+ * @file core.hpp
+ * @brief mymath的数值内核,只依赖C++20标准库,不需要python解释器
+ *
+ * cython模块`mymath.normalize`,`mymath.inner.l2norm`和`mymath.median_along_axis0`都只是这里的薄包装,
+ * C++服务可以直接包含这个头文件获得相同的性能.
+ * 使用`-fopenmp`编译时循环会并行执行,否则顺序执行,也不会因为不认识`omp`编译指示产生警告.
+ */
+#ifndef MYMATH_CORE_HPP_
+#define MYMATH_CORE_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _OPENMP
+#define MYMATH_OMP(directive) _Pragma(#directive)
+#else
+#define MYMATH_OMP(directive)
+#endif
+
+namespace mymath {
+
+/**
+ * @fn l2norm
+ * @brief 向量的L2范数
+ * @param[x] 输入向量
+ */
+template <std::floating_point T>
+T l2norm(std::span<const T> x) noexcept {
+    T total = 0;
+    const auto n = static_cast<std::ptrdiff_t>(x.size());
+    MYMATH_OMP(omp parallel for reduction(+ : total))
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+        total += x[i] * x[i];
+    }
+    return std::sqrt(total);
+}
+
+/**
+ * @fn normalize
+ * @brief 将向量除以它的L2范数,结果写入out
+ * @param[x] 输入向量
+ * @param[out] 输出,长度必须和x相同,可以和x是同一块内存
+ * @exception <std::invalid_argument> { out的长度和x不同 }
+ */
+template <std::floating_point T>
+void normalize(std::span<const T> x, std::span<T> out) {
+    if (out.size() != x.size()) {
+        throw std::invalid_argument("normalize: out must have the same size as x");
+    }
+    const T norm = l2norm(x);
+    const auto n = static_cast<std::ptrdiff_t>(x.size());
+    MYMATH_OMP(omp parallel for)
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+        out[i] = x[i] / norm;
+    }
+}
+
+/**
+ * @fn median_along_axis0
+ * @brief 按列求行优先存储的矩阵的中位数,行数为偶数时取中间靠后的元素
+ * @param[x] 矩阵,`x[i * cols + j]`为第i行第j列
+ * @param[rows] 行数
+ * @param[cols] 列数
+ * @param[out] 输出,长度必须为cols
+ * @exception <std::invalid_argument> { x或out的长度和行列数不符,或者有列但没有行 }
+ */
+template <std::floating_point T>
+void median_along_axis0(std::span<const T> x, std::size_t rows, std::size_t cols, std::span<T> out) {
+    if (x.size() != rows * cols || out.size() != cols) {
+        throw std::invalid_argument("median_along_axis0: size mismatch");
+    }
+    if (rows == 0) {
+        // 没有行时中位数没有定义,不能留下未写入的输出
+        if (cols > 0) {
+            throw std::invalid_argument("median_along_axis0: x has no rows");
+        }
+        return;
+    }
+    const auto n = static_cast<std::ptrdiff_t>(cols);
+    MYMATH_OMP(omp parallel)
+    {
+        // 每个线程一份缓存,按列拆分任务
+        std::vector<T> scratch(rows);
+        MYMATH_OMP(omp for)
+        for (std::ptrdiff_t j = 0; j < n; ++j) {
+            for (std::size_t i = 0; i < rows; ++i) {
+                scratch[i] = x[i * cols + j];
+            }
+            auto middle = scratch.begin() + rows / 2;
+            std::nth_element(scratch.begin(), middle, scratch.end());
+            out[j] = *middle;
+        }
+    }
+}
+
+}  // namespace mymath
+
+#undef MYMATH_OMP
+
+#endif /* MYMATH_CORE_HPP_ */
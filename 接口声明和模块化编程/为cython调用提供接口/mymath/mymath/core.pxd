@@ -0,0 +1,24 @@
+# distutils: language = c++
+# `inc/mymath/core.hpp`中数值内核的声明,只支持double,cython模块通过它调用C++实现
+
+from libcpp.span cimport span
+
+# 模版参数中不能直接写const,构造时需要用别名
+ctypedef const double const_double
+
+cdef extern from "mymath/core.hpp" namespace "mymath" nogil:
+    double l2norm "mymath::l2norm<double>" (span[const double] x)
+    void normalize "mymath::normalize<double>" (span[const double] x, span[double] out) except +
+    void median_along_axis0 "mymath::median_along_axis0<double>" (span[const double] x, size_t rows, size_t cols, span[double] out) except +
+
+
+cdef inline span[const double] const_span(const double[::1] x) noexcept nogil:
+    if x.shape[0] == 0:
+        return span[const_double]()
+    return span[const_double](&x[0], <size_t>x.shape[0])
+
+
+cdef inline span[double] mutable_span(double[::1] x) noexcept nogil:
+    if x.shape[0] == 0:
+        return span[double]()
+    return span[double](&x[0], <size_t>x.shape[0])
@@ -1,15 +1,13 @@
-# distutils: extra_compile_args=-fopenmp
+# distutils: language = c++
+# distutils: extra_compile_args=-fopenmp -std=c++20
 # distutils: extra_link_args=-fopenmp
+# distutils: include_dirs=inc
 
-from cython.parallel cimport prange
-cimport cython
-from libc.math cimport sqrt
+from mymath cimport core
+import numpy as np
 
-@cython.boundscheck(False)
-@cython.wraparound(False)
 cpdef double l2norm(double[:] x):
-    cdef double total = 0
-    cdef Py_ssize_t i
-    for i in prange(x.shape[0], nogil=True):
-        total += x[i]*x[i]
-    return sqrt(total)
+    # C++内核只接受连续内存,不连续的输入先复制一份,连续的输入不会复制
+    cdef const double[::1] xc = np.ascontiguousarray(x)
+    with nogil:
+        return core.l2norm(core.const_span(xc))
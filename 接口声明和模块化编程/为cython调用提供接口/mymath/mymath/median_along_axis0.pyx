@@ -1,38 +1,26 @@
 # distutils: language = c++
-# distutils: extra_compile_args=-fopenmp
+# distutils: extra_compile_args=-fopenmp -std=c++20
 # distutils: extra_link_args=-fopenmp
+# distutils: include_dirs=inc
 
-from cython.parallel cimport parallel, prange
-from libcpp.vector cimport vector
-from libcpp.algorithm cimport nth_element
-cimport cython
-from cython.operator cimport dereference
+from libcpp.span cimport span
+from mymath cimport core
 
 import numpy as np
 
-@cython.boundscheck(False)
-@cython.wraparound(False)
 cdef double[::1]  _median_along_axis0(const double[:,:] x):
     cdef double[::1] out = np.empty(x.shape[1])
-    cdef Py_ssize_t i, j
-
-    cdef vector[double] *scratch # 缓存的vector
-    cdef vector[double].iterator median_it # 缓存的vector中中间位置迭代器
-    with nogil, parallel():
-        scratch = new vector[double](x.shape[0]) # 在线程中构造缓存
-        try:
-            for i in prange(x.shape[1]): # 按列拆分任务
-                # 将当列的每一行元素复制到缓存的vector
-                for j in range(x.shape[0]):
-                    dereference(scratch)[j] = x[j, i]
-                median_it = scratch.begin() + scratch.size()//2 # 计算中间位置的index
-                nth_element(scratch.begin(), median_it, scratch.end()) #使用`std::nth_element`对中间位置进行部分排序
-                # for the sake of a simple example, don't handle even lengths...
-                out[i] = dereference(median_it)# 从迭代器中取出中位数
-        finally:
-            del scratch # 销毁缓存
+    # C++内核按行优先的连续内存读取矩阵,不连续的输入先复制一份,连续的输入不会复制
+    cdef const double[:, ::1] xc = np.ascontiguousarray(x)
+    cdef size_t rows = xc.shape[0]
+    cdef size_t cols = xc.shape[1]
+    cdef span[core.const_double] data
+    if rows * cols > 0:
+        data = span[core.const_double](&xc[0, 0], rows * cols)
+    with nogil:
+        core.median_along_axis0(data, rows, cols, core.mutable_span(out))
     return out
 
 def median_along_axis0(const double[:,:] x):
     cdef double[::1] out = _median_along_axis0(x)
-    return np.asarray(out)
\ No newline at end of file
+    return np.asarray(out)
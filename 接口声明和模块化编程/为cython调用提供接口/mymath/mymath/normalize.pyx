@@ -1,28 +1,21 @@
-# distutils: extra_compile_args=-fopenmp
+# distutils: language = c++
+# distutils: extra_compile_args=-fopenmp -std=c++20
 # distutils: extra_link_args=-fopenmp
+# distutils: include_dirs=inc
 
-from cython.parallel cimport parallel, prange
-cimport cython
-from libc.math cimport sqrt
+from mymath cimport core
 import numpy as np
 
 
-@cython.boundscheck(False)
-@cython.wraparound(False)
 cdef double[:] _normalize(double[:] x):
-    cdef Py_ssize_t i
-    cdef double total = 0
-    cdef double norm
-    cdef double[:] output = np.empty_like(x)
-    with nogil, parallel():
-        for i in prange(x.shape[0]):
-            total += x[i]*x[i]
-        norm = sqrt(total)
-        for i in prange(x.shape[0]):
-            output[i] = x[i]/norm
+    # C++内核只接受连续内存,不连续的输入先复制一份,连续的输入不会复制
+    cdef const double[::1] xc = np.ascontiguousarray(x)
+    cdef double[::1] output = np.empty(x.shape[0])
+    with nogil:
+        core.normalize(core.const_span(xc), core.mutable_span(output))
     return output
 
 
 def normalize(double[:] x):
     cdef double[:] output = _normalize(x)
-    return np.asarray(output)
\ No newline at end of file
+    return np.asarray(output)
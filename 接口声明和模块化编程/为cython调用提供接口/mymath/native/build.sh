@@ -0,0 +1,2 @@
+# 在mymath文件夹下执行,只需要C++20编译器,不依赖python
+g++ -std=c++20 -O3 -march=native -fopenmp -I inc -o native/bench_native native/main.cpp
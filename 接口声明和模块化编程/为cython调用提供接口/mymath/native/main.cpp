@@ -0,0 +1,47 @@
+/**
+ * @file main.cpp
+ * @brief 不经过python直接调用`mymath/core.hpp`,数据规模和`bench_profiles.py`中的大数组一致
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "mymath/core.hpp"
+
+template <typename F>
+double best_ms(int repeat, F&& func) {
+    double best = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < repeat; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        std::chrono::duration<double, std::milli> cost = std::chrono::steady_clock::now() - start;
+        best = std::min(best, cost.count());
+    }
+    return best;
+}
+
+int main() {
+    std::mt19937_64 gen(0);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    std::vector<double> vector(2'000'000);
+    std::vector<double> matrix(501 * 2'000);
+    std::generate(vector.begin(), vector.end(), [&] { return dist(gen); });
+    std::generate(matrix.begin(), matrix.end(), [&] { return dist(gen); });
+
+    std::vector<double> normalized(vector.size());
+    std::vector<double> median(2'000);
+    volatile double sink = 0;
+    auto normalize_ms = best_ms(20, [&] { mymath::normalize<double>(vector, normalized); });
+    auto l2norm_ms = best_ms(20, [&] { sink = mymath::l2norm<double>(vector); });
+    auto median_ms = best_ms(10, [&] { mymath::median_along_axis0<double>(matrix, 501, 2'000, median); });
+    std::printf("normalize           %8.2fms\n", normalize_ms);
+    std::printf("l2norm              %8.2fms\n", l2norm_ms);
+    std::printf("median_along_axis0  %8.2fms\n", median_ms);
+    // float同样可用
+    std::vector<float> small{3.0f, 4.0f};
+    std::printf("l2norm<float>({3, 4}) = %.1f\n", mymath::l2norm<float>(small));
+    return 0;
+}
@@ -0,0 +1,30 @@
+"""`pgo_build.py`使用的代表性工作负载,最后一行输出耗时(秒).
+
+覆盖包中导出的函数:小数组上的频繁调用和大数组上的计算各占一部分.
+"""
+import time
+
+import numpy as np
+
+import mymath
+
+
+def main() -> None:
+    rng = np.random.default_rng(0)
+    small = rng.random(64)
+    large = rng.random(200_000)
+    matrix = rng.random((101, 64))
+    start = time.perf_counter()
+    for _ in range(20_000):
+        mymath.normalize(small)
+        mymath.l2norm(small)
+    for _ in range(50):
+        mymath.normalize(large)
+        mymath.l2norm(large)
+    for _ in range(2_000):
+        mymath.median_along_axis0(matrix)
+    print(time.perf_counter() - start)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,22 @@
+import os
+
+from setuptools import setup
+
+from build_profiles import LIMITED_API_TAG, extensions
+
+# MYMATH_PROFILE=checked python setup.py build_ext --inplace --force
+# MYMATH_PROFILE=native python setup.py build_ext --inplace --force
+# MYMATH_LIMITED_API=all python setup.py bdist_wheel
+# MYMATH_LIMITED_API=mymath.normalize,mymath.inner.l2norm python setup.py build_ext --inplace --force
+limited_api = [name for name in os.environ.get("MYMATH_LIMITED_API", "").split(",") if name]
+options = {}
+if "all" in limited_api:
+    # 全部模块都只使用Limited API时才能打成abi3的wheel
+    options["bdist_wheel"] = {"py_limited_api": LIMITED_API_TAG}
+
+setup(
+    name="mymath",
+    packages=["mymath", "mymath.inner"],
+    ext_modules=extensions(os.environ.get("MYMATH_PROFILE", "release"), limited_api=limited_api),
+    options=options,
+)
@@ -0,0 +1,140 @@
+"""用PGO(profile-guided optimization)和LTO构造本章的cython扩展模块.
+
+对每个模块依次执行:
+
+1. 按`# distutils:`头部的默认设置(有`build_profiles.py`的模块使用其中的`release`配置)编译,执行模块自带的`pgo_workload.py`,记录基准耗时
+2. 加上`-fprofile-generate`编译插桩版本,执行一次`pgo_workload.py`收集分支和调用频率
+3. 加上`-fprofile-use -flto`重新编译,再次执行`pgo_workload.py`,输出相对基准的加速比
+
+最终留在模块目录中的就是优化后的动态链接库.中间文件放在各模块的`build/pgo`下,
+编译目录固定,这样第3步才能按目标文件路径找到第2步生成的`.gcda`.
+
+需要gcc;`binary_vector`依赖的`libvector.so`需要先在`wrapC/vec`下执行`build_dynamic.sh`.
+
+用法:
+    python pgo_build.py [mymath] [binary_vector] [rectangle]
+"""
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+from contextlib import contextmanager
+from dataclasses import dataclass, field
+from pathlib import Path
+
+HERE = Path(__file__).resolve().parent
+
+
+@dataclass
+class Module:
+    directory: str
+    sources: list[str]
+    env: dict[str, str] = field(default_factory=dict)
+    requires: list[str] = field(default_factory=list)
+
+
+MODULES = {
+    "mymath": Module("mymath", ["mymath/**/*.pyx"]),
+    "binary_vector": Module("wrapC", ["binary_vector.pyx"], env={"LD_LIBRARY_PATH": "vec/lib"},
+                            requires=["vec/lib/libvector.so"]),
+    "rectangle": Module("wrapCpp", ["Rectangle.pyx"]),
+}
+
+REPEAT = 5
+
+
+@contextmanager
+def chdir(path: Path):
+    old = Path.cwd()
+    os.chdir(path)
+    try:
+        yield
+    finally:
+        os.chdir(old)
+
+
+def build(module: Module, compile_args: list[str], link_args: list[str]) -> None:
+    """在模块目录中原地编译,额外的参数追加在`# distutils:`头部设置的参数之后."""
+    from Cython.Build import cythonize
+    from setuptools import setup
+
+    root = HERE / module.directory
+    with chdir(root):
+        if (root / "build_profiles.py").exists():
+            # 模块有集中的编译配置时使用其中的release配置
+            sys.path.insert(0, str(root))
+            try:
+                from build_profiles import extensions as profile_extensions
+            finally:
+                sys.path.remove(str(root))
+            extensions = profile_extensions("release")
+        else:
+            extensions = cythonize(module.sources, language_level=3, quiet=True)
+        for ext in extensions:
+            ext.extra_compile_args = list(ext.extra_compile_args) + compile_args
+            ext.extra_link_args = list(ext.extra_link_args) + link_args
+        setup(
+            script_name="pgo_build.py",
+            script_args=["-q", "build_ext", "--inplace", "--force", "--build-temp", str(root / "build" / "pgo" / "temp")],
+            ext_modules=extensions,
+        )
+
+
+def run_workload(module: Module) -> float:
+    """执行`pgo_workload.py`,返回它最后一行输出的耗时(秒)."""
+    root = HERE / module.directory
+    env = dict(os.environ)
+    for key, value in module.env.items():
+        env[key] = os.pathsep.join(filter(None, [str(root / value), env.get(key)]))
+    env["PYTHONPATH"] = os.pathsep.join(filter(None, [str(root), env.get("PYTHONPATH")]))
+    out = subprocess.run([sys.executable, "pgo_workload.py"], cwd=root, env=env, check=True, capture_output=True, text=True)
+    return float(out.stdout.split()[-1])
+
+
+def best_of(module: Module) -> float:
+    return min(run_workload(module) for _ in range(REPEAT))
+
+
+def pgo(name: str, module: Module) -> tuple[float, float]:
+    root = HERE / module.directory
+    for required in module.requires:
+        if not (root / required).exists():
+            raise SystemExit(f"{name}: missing {root / required}")
+    profile_dir = root / "build" / "pgo" / "profile"
+    shutil.rmtree(profile_dir, ignore_errors=True)
+
+    print(f"[{name}] baseline build")
+    build(module, [], [])
+    baseline = best_of(module)
+
+    print(f"[{name}] instrumented build")
+    generate = [f"-fprofile-generate={profile_dir}"]
+    build(module, generate, generate)
+    run_workload(module)
+
+    print(f"[{name}] profile-use + LTO build")
+    # 训练中没有执行到的函数不会有profile数据,不需要为此报警
+    use = [f"-fprofile-use={profile_dir}", "-fprofile-correction", "-Wno-missing-profile", "-flto=auto"]
+    build(module, use, use)
+    optimized = best_of(module)
+    return baseline, optimized
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("modules", nargs="*", help=f"默认全部: {' '.join(MODULES)}")
+    args = parser.parse_args()
+    unknown = set(args.modules) - set(MODULES)
+    if unknown:
+        parser.error(f"unknown modules: {' '.join(sorted(unknown))}")
+    args.modules = args.modules or list(MODULES)
+
+    results = {name: pgo(name, MODULES[name]) for name in args.modules}
+    print(f"\n{'module':<16}{'baseline':>12}{'pgo+lto':>12}{'speedup':>10}")
+    for name, (baseline, optimized) in results.items():
+        print(f"{name:<16}{baseline * 1000:>10.1f}ms{optimized * 1000:>10.1f}ms{baseline / optimized:>9.2f}x")
+
+
+if __name__ == "__main__":
+    main()
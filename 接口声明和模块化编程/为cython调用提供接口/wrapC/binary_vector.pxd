@@ -1,4 +1,4 @@
-cdef extern from "./vec/inc/binary_vector.h":
+cdef extern from "./vec/inc/binary_vector.h" nogil:
 
     cdef struct BINARY_VECTOR:
         float x
@@ -26,3 +26,12 @@ cdef class Vector:
     cdef create(BINARY_VECTOR_P ptr)
 
     cdef void init_from_point(self,BINARY_VECTOR_P ptr)
+
+
+cdef api BINARY_VECTOR_P vector_new(float x, float y) noexcept nogil
+
+cdef api void vector_del(BINARY_VECTOR_P v) noexcept nogil
+
+cdef api float vector_mod(BINARY_VECTOR_P v) noexcept nogil
+
+cdef api BINARY_VECTOR_P vector_add(BINARY_VECTOR_P a, BINARY_VECTOR_P b) noexcept nogil
@@ -38,3 +38,24 @@ cdef class Vector:
 
     def __mul__(self,other: Vector)->float:
         return VEC_mul(self.data, other.data)
+
+
+# C接口,转译时会生成`binary_vector_api.h`,C/C++程序调用`import_binary_vector()`后
+# 就可以直接使用下面的函数,不经过python对象协议,也不需要把float装箱成`PyFloat`.
+# 这些函数不访问python对象,因此都声明为`nogil`.
+
+cdef api BINARY_VECTOR_P vector_new(float x, float y) noexcept nogil:
+    """构造向量,需要用`vector_del`释放."""
+    return VEC_init(x, y)
+
+cdef api void vector_del(BINARY_VECTOR_P v) noexcept nogil:
+    """释放`vector_new`或`vector_add`构造的向量."""
+    VEC_del(v)
+
+cdef api float vector_mod(BINARY_VECTOR_P v) noexcept nogil:
+    """向量的模."""
+    return VEC_mod(v)
+
+cdef api BINARY_VECTOR_P vector_add(BINARY_VECTOR_P a, BINARY_VECTOR_P b) noexcept nogil:
+    """向量相加,返回新的向量,需要用`vector_del`释放."""
+    return VEC_add(a, b)
@@ -0,0 +1,100 @@
+/* Generated by Cython 3.3.0 */
+
+#ifndef __PYX_HAVE_API__binary_vector
+#define __PYX_HAVE_API__binary_vector
+#ifdef __MINGW64__
+#define MS_WIN64
+#endif
+#include "Python.h"
+
+static BINARY_VECTOR_P (*__pyx_api_f_13binary_vector_vector_new)(float, float) = 0;
+#define vector_new __pyx_api_f_13binary_vector_vector_new
+static void (*__pyx_api_f_13binary_vector_vector_del)(BINARY_VECTOR_P) = 0;
+#define vector_del __pyx_api_f_13binary_vector_vector_del
+static float (*__pyx_api_f_13binary_vector_vector_mod)(BINARY_VECTOR_P) = 0;
+#define vector_mod __pyx_api_f_13binary_vector_vector_mod
+static BINARY_VECTOR_P (*__pyx_api_f_13binary_vector_vector_add)(BINARY_VECTOR_P, BINARY_VECTOR_P) = 0;
+#define vector_add __pyx_api_f_13binary_vector_vector_add
+static int __Pyx_ImportFunction_3_3_0(PyObject *module, const char *funcname, void (**f)(void), const char *sig);
+
+#ifndef __PYX_HAVE_RT_ImportFromPxd_3_3_0
+#define __PYX_HAVE_RT_ImportFromPxd_3_3_0
+static int __Pyx_ImportFromPxd_3_3_0(PyObject *module, const char *name, void **p, const char *sig, const char *what, int optional) {
+    PyObject *d = 0;
+    PyObject *cobj = 0;
+    d = PyObject_GetAttrString(module, "__pyx_capi__");
+    if (!d)
+        goto bad;
+#if (defined(Py_LIMITED_API) && Py_LIMITED_API >= 0x030d0000) || (!defined(Py_LIMITED_API) && PY_VERSION_HEX >= 0x030d0000)
+    PyDict_GetItemStringRef(d, name, &cobj);
+#else
+    cobj = PyDict_GetItemString(d, name);
+    Py_XINCREF(cobj);
+#endif
+    if (!cobj) {
+        if (optional && !PyErr_Occurred()) {
+            PyErr_Clear();
+            *p = NULL;
+            goto allowed_failure;
+        } else {
+            PyErr_Format(PyExc_ImportError,
+                "%.200s does not export expected C %.8s %.200s",
+                    PyModule_GetName(module), what, name);
+            goto bad;
+        }
+    }
+    if (!PyCapsule_IsValid(cobj, sig)) {
+        PyErr_Format(PyExc_TypeError,
+            "C %.8s %.200s.%.200s has wrong signature (expected %.500s, got %.500s)",
+             what, PyModule_GetName(module), name, sig, PyCapsule_GetName(cobj));
+        goto bad;
+    }
+    *p = PyCapsule_GetPointer(cobj, sig);
+    if (!(*p))
+        goto bad;
+    Py_DECREF(cobj);
+allowed_failure:
+    Py_DECREF(d);
+    return 0;
+bad:
+    Py_XDECREF(d);
+    Py_XDECREF(cobj);
+    return -1;
+}
+#endif
+
+#ifndef __PYX_HAVE_RT_ImportFunction_3_3_0
+#define __PYX_HAVE_RT_ImportFunction_3_3_0
+static int __Pyx_ImportFunction_3_3_0(PyObject *module, const char *funcname, void (**f)(void), const char *sig) {
+    if (*f) {
+        return 0; // already imported under a different name
+    }
+    union {
+        void (*fp)(void);
+        void *p;
+    } tmp;
+    int result = __Pyx_ImportFromPxd_3_3_0(module, funcname, &tmp.p, sig, "function", 0);
+    if (result == 0) {
+        *f = tmp.fp;
+    }
+    return result;
+}
+#endif
+
+
+static int import_binary_vector(void) {
+  PyObject *module = 0;
+  module = PyImport_ImportModule("binary_vector");
+  if (!module) goto bad;
+  if (__Pyx_ImportFunction_3_3_0(module, "vector_new", (void (**)(void))&__pyx_api_f_13binary_vector_vector_new, "BINARY_VECTOR_P (float, float)") < 0) goto bad;
+  if (__Pyx_ImportFunction_3_3_0(module, "vector_del", (void (**)(void))&__pyx_api_f_13binary_vector_vector_del, "void (BINARY_VECTOR_P)") < 0) goto bad;
+  if (__Pyx_ImportFunction_3_3_0(module, "vector_mod", (void (**)(void))&__pyx_api_f_13binary_vector_vector_mod, "float (BINARY_VECTOR_P)") < 0) goto bad;
+  if (__Pyx_ImportFunction_3_3_0(module, "vector_add", (void (**)(void))&__pyx_api_f_13binary_vector_vector_add, "BINARY_VECTOR_P (BINARY_VECTOR_P, BINARY_VECTOR_P)") < 0) goto bad;
+  Py_DECREF(module); module = 0;
+  return 0;
+  bad:
+  Py_XDECREF(module);
+  return -1;
+}
+
+#endif /* !__PYX_HAVE_API__binary_vector */
@@ -0,0 +1,25 @@
+"""`pgo_build.py`使用的代表性工作负载,最后一行输出耗时(秒).
+
+`Vector`析构时会打印,因此先构造好一批向量,循环中只调用不分配新向量的方法.
+"""
+import time
+
+from binary_vector import Vector
+
+
+def main() -> None:
+    vectors = [Vector.new(float(i % 97), float(i % 89)) for i in range(1_000)]
+    start = time.perf_counter()
+    total = 0.0
+    for _ in range(2_000):
+        for a, b in zip(vectors, vectors[1:]):
+            total += a.mod() + a * b
+    elapsed = time.perf_counter() - start
+    # 先释放向量,让析构时的打印出现在耗时之前
+    del vectors, a, b
+    print(total)
+    print(elapsed)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,21 @@
+"""`pgo_build.py`使用的代表性工作负载,最后一行输出耗时(秒)."""
+import time
+
+from Rectangle import PyRectangle
+
+
+def main() -> None:
+    start = time.perf_counter()
+    total = 0
+    for i in range(200_000):
+        rect = PyRectangle(0, 0, i % 100 + 1, i % 37 + 1)
+        rect.move(1, 2)
+        width, height = rect.get_size()
+        rect.x1 = rect.x1 + 1
+        total += rect.get_area() + width + height
+    print(total)
+    print(time.perf_counter() - start)
+
+
+if __name__ == "__main__":
+    main()
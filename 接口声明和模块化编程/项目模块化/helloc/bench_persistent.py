@@ -0,0 +1,116 @@
+"""对比`hellocexec`单次调用模式(`-s`)和常驻模式(`-i`标准输入, `-u`unix套接字)的延迟.
+
++ `oneshot`,每个名字启动一次进程,包含解释器的初始化和回收
++ `stdin`/`unix`,解释器只初始化一次,逐个发送名字并等待输出(回复)后再发下一个
++ `stdin batch`/`unix batch`,一次写入所有名字,按总耗时折算成每个名字的平均耗时
+
+用法:
+    python bench_persistent.py [--exe ./hellocexec] [-n 200]
+"""
+import argparse
+import os
+import socket
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def summary(name: str, samples: list[float]) -> None:
+    samples = sorted(samples)
+    p99 = samples[min(len(samples) - 1, int(len(samples) * 0.99))]
+    print(f"{name:<14}{len(samples):>7}{statistics.mean(samples) * 1e6:>12.1f}{samples[len(samples) // 2] * 1e6:>12.1f}{p99 * 1e6:>12.1f}")
+
+
+def bench_oneshot(exe: str, n: int) -> list[float]:
+    samples = []
+    for i in range(n):
+        start = time.perf_counter()
+        subprocess.run([exe, "-s", f"name{i}"], check=True, stdout=subprocess.DEVNULL)
+        samples.append(time.perf_counter() - start)
+    return samples
+
+
+def bench_stdin(exe: str, n: int) -> tuple[list[float], float]:
+    proc = subprocess.Popen([exe, "-i"], stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+    samples = []
+    for i in range(n):
+        start = time.perf_counter()
+        proc.stdin.write(f"name{i}\n".encode())
+        proc.stdin.flush()
+        proc.stdout.readline()
+        samples.append(time.perf_counter() - start)
+    proc.stdin.close()
+    proc.wait()
+
+    proc = subprocess.Popen([exe, "-i"], stdin=subprocess.PIPE, stdout=subprocess.DEVNULL)
+    payload = "".join(f"name{i}\n" for i in range(n)).encode()
+    # 先等待解释器初始化完成,只统计处理的耗时
+    time.sleep(0.5)
+    start = time.perf_counter()
+    proc.communicate(payload)
+    return samples, (time.perf_counter() - start) / n
+
+
+def connect_unix(path: str, timeout: float = 10.0) -> socket.socket:
+    """连接`path`,服务端还没有开始`listen`时重试,套接字文件出现得比`listen`早."""
+    deadline = time.monotonic() + timeout
+    while True:
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            sock.connect(path)
+            return sock
+        except (FileNotFoundError, ConnectionRefusedError):
+            sock.close()
+            if time.monotonic() >= deadline:
+                raise
+            time.sleep(0.01)
+
+
+def bench_unix(exe: str, n: int) -> tuple[list[float], float]:
+    with tempfile.TemporaryDirectory(prefix="helloc-") as tmp:
+        path = os.path.join(tmp, "helloc.sock")
+        proc = subprocess.Popen([exe, "-u", path], stdout=subprocess.DEVNULL)
+        try:
+            samples = []
+            with connect_unix(path) as sock:
+                reader = sock.makefile("rb")
+                for i in range(n):
+                    start = time.perf_counter()
+                    sock.sendall(f"name{i}\n".encode())
+                    reader.readline()
+                    samples.append(time.perf_counter() - start)
+            with connect_unix(path) as sock:
+                reader = sock.makefile("rb")
+                start = time.perf_counter()
+                sock.sendall("".join(f"name{i}\n" for i in range(n)).encode())
+                for _ in range(n):
+                    reader.readline()
+                batch = (time.perf_counter() - start) / n
+        finally:
+            proc.terminate()
+            proc.wait()
+    return samples, batch
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--exe", default="./hellocexec", help="hellocexec的路径")
+    parser.add_argument("-n", type=int, default=200, help="每种模式发送的名字数")
+    args = parser.parse_args()
+    if not os.access(args.exe, os.X_OK):
+        sys.exit(f"{args.exe} not found, build it with build_c_model.sh first")
+
+    print(f"{'mode':<14}{'calls':>7}{'mean(us)':>12}{'p50(us)':>12}{'p99(us)':>12}")
+    summary("oneshot", bench_oneshot(args.exe, min(args.n, 50)))
+    samples, batch = bench_stdin(args.exe, args.n)
+    summary("stdin", samples)
+    summary("stdin batch", [batch])
+    samples, batch = bench_unix(args.exe, args.n)
+    summary("unix", samples)
+    summary("unix batch", [batch])
+
+
+if __name__ == "__main__":
+    main()
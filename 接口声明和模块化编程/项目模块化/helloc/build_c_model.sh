@@ -13,7 +13,13 @@ rename helloc/helloc.h helloc/helloc.helloc.h
 g++ -I /Users/mac/micromamba/envs/py3.10/include/python3.10 -L/Users/mac/micromamba/envs/py3.10/lib -lpython3.10 main.cpp ./helloc/helloc.cpp ./helloc/universal/funcs.cpp -o hellocexec
 
 
+# fastlog.hpp使用了C++20和std::thread
+# ./hellocexec -s world 调用一次hello
+# ./hellocexec -b 2000 -t 4 > /dev/null 对比4个线程各调用2000次hello和hello_log的耗时
+# ./hellocexec -i [-n 64] 常驻模式,从标准输入逐行读取名字,每批最多64个
+# ./hellocexec -u /tmp/helloc.sock [-n 64] 常驻模式,在unix套接字上按行接收名字,每个名字回复一行`ok <名字>`,每个连接一个线程
+# python bench_persistent.py 对比单次调用和常驻模式的延迟
 cython --3 -+ src/**/*.pyx
-g++ -I /Users/mac/micromamba/envs/py3.10/include/python3.10 -o ./src/helloc.o -c ./src/helloc.cpp
-g++ -I /Users/mac/micromamba/envs/py3.10/include/python3.10 -o ./src/main.o -c ./src/main.cpp
-g++ -L/Users/mac/micromamba/envs/py3.10/lib -lpython3.10 ./src/main.o ./src/helloc.o -o hellocexec
\ No newline at end of file
+g++ -std=c++20 -pthread -I /Users/mac/micromamba/envs/py3.10/include/python3.10 -o ./src/helloc.o -c ./src/helloc.cpp
+g++ -std=c++20 -pthread -I /Users/mac/micromamba/envs/py3.10/include/python3.10 -o ./src/main.o -c ./src/main.cpp
+g++ -pthread -L/Users/mac/micromamba/envs/py3.10/lib -lpython3.10 ./src/main.o ./src/helloc.o -o hellocexec
\ No newline at end of file
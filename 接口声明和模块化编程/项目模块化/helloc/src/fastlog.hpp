@@ -0,0 +1,221 @@
+/**
+ * @file fastlog.hpp
+ * @brief 不经过GIL和python的`print`的日志输出
+ *
+ * 调用方在线程局部的缓冲中拼好带时间戳的一行,复制进无锁的环形缓冲就返回;
+ * 后台线程批量取出并`write`到文件描述符.调用方之间只竞争一次CAS,不会因为写标准输出而互相等待.
+ * 环形缓冲满时丢弃新的日志并计数,不阻塞调用方.
+ */
+#ifndef FASTLOG_HPP_
+#define FASTLOG_HPP_
+
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace fastlog {
+
+// 一行日志的最大长度(含时间戳和换行),超出部分截断
+constexpr std::size_t RECORD_SIZE = 240;
+// 环形缓冲的槽数,必须是2的幂
+constexpr std::size_t CAPACITY = 8192;
+// 缓冲为空时后台线程的等待时间
+constexpr std::chrono::microseconds IDLE_WAIT{500};
+
+/**
+ * @fn format_timestamp
+ * @brief 以`秒.纳秒`的格式写入`CLOCK_REALTIME`的当前时间
+ * @param[buf]  输出缓冲,至少要有32字节
+ * @return  写入的字节数
+ */
+inline std::size_t format_timestamp(char* buf) noexcept {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    char* p = std::to_chars(buf, buf + 20, static_cast<long long>(ts.tv_sec)).ptr;
+    *p++ = '.';
+    long nsec = ts.tv_nsec;
+    for (int i = 8; i >= 0; --i) {
+        p[i] = static_cast<char>('0' + nsec % 10);
+        nsec /= 10;
+    }
+    return static_cast<std::size_t>(p + 9 - buf);
+}
+
+/**
+ * @brief 多生产者单消费者的日志器
+ * @details 环形缓冲使用Vyukov的有界队列,每个槽带一个序号,生产者用CAS抢占写入位置,
+ *          写完后发布序号;唯一的消费者是后台线程,按序号判断槽是否可读.
+ */
+class Logger {
+   public:
+    /**
+     * @param[fd]  输出的文件描述符,默认为标准输出
+     */
+    explicit Logger(int fd = STDOUT_FILENO) : fd_(fd) {
+        for (std::size_t i = 0; i < CAPACITY; ++i) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+        flusher_ = std::thread([this] { run(); });
+    }
+
+    ~Logger() {
+        stopping_.store(true, std::memory_order_release);
+        flusher_.join();
+        auto dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped > 0) {
+            std::fprintf(stderr, "fastlog: dropped %llu records\n", static_cast<unsigned long long>(dropped));
+        }
+    }
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    /**
+     * @fn instance
+     * @brief 输出到标准输出的全局日志器,第一次调用时启动后台线程,进程退出时写完剩余的日志
+     */
+    static Logger& instance() {
+        static Logger logger;
+        return logger;
+    }
+
+    /**
+     * @fn log
+     * @brief 输出一行`<时间戳> <parts...>\n`
+     * @param[parts]  依次拼接的文本
+     * @return  环形缓冲已满而被丢弃时返回false
+     */
+    template <typename... Parts>
+    bool log(const Parts&... parts) noexcept {
+        thread_local std::array<char, RECORD_SIZE> buf;
+        std::size_t len = format_timestamp(buf.data());
+        buf[len++] = ' ';
+        ((len = append(buf.data(), len, std::string_view(parts))), ...);
+        buf[len++] = '\n';
+        return push(buf.data(), len);
+    }
+
+    /**
+     * @fn flush
+     * @brief 等待调用前提交的日志全部写出
+     */
+    void flush() const noexcept {
+        auto target = head_.load(std::memory_order_acquire);
+        while (written_.load(std::memory_order_acquire) < target) {
+            std::this_thread::sleep_for(IDLE_WAIT);
+        }
+    }
+
+    /**
+     * @fn dropped
+     * @brief 因环形缓冲已满而丢弃的日志条数
+     */
+    std::uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+   private:
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> seq;
+        std::uint32_t len;
+        char data[RECORD_SIZE];
+    };
+
+    static std::size_t append(char* buf, std::size_t len, std::string_view part) noexcept {
+        // 留一个字节给换行
+        auto n = std::min(part.size(), RECORD_SIZE - 1 - len);
+        std::memcpy(buf + len, part.data(), n);
+        return len + n;
+    }
+
+    bool push(const char* data, std::size_t len) noexcept {
+        auto pos = head_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & (CAPACITY - 1)];
+            auto seq = slot->seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::int64_t>(seq - pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // 消费者还没读走上一轮的数据,缓冲已满
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        std::memcpy(slot->data, data, len);
+        slot->len = static_cast<std::uint32_t>(len);
+        slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    void run() {
+        std::string batch;
+        batch.reserve(CAPACITY / 4 * RECORD_SIZE);
+        std::uint64_t tail = 0;
+        for (;;) {
+            // 先读停止标记再取数据,保证停止前提交的日志都能写出
+            bool stopping = stopping_.load(std::memory_order_acquire);
+            std::uint64_t taken = 0;
+            while (batch.size() + RECORD_SIZE <= batch.capacity()) {
+                Slot& slot = slots_[tail & (CAPACITY - 1)];
+                if (slot.seq.load(std::memory_order_acquire) != tail + 1) {
+                    break;
+                }
+                batch.append(slot.data, slot.len);
+                slot.seq.store(tail + CAPACITY, std::memory_order_release);
+                ++tail;
+                ++taken;
+            }
+            if (taken > 0) {
+                write_all(batch.data(), batch.size());
+                batch.clear();
+                written_.fetch_add(taken, std::memory_order_release);
+            } else if (stopping) {
+                return;
+            } else {
+                std::this_thread::sleep_for(IDLE_WAIT);
+            }
+        }
+    }
+
+    void write_all(const char* data, std::size_t len) noexcept {
+        while (len > 0) {
+            auto n = ::write(fd_, data, len);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            data += n;
+            len -= static_cast<std::size_t>(n);
+        }
+    }
+
+    int fd_;
+    alignas(64) std::atomic<std::uint64_t> head_{0};
+    alignas(64) std::atomic<std::uint64_t> written_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<bool> stopping_{false};
+    std::array<Slot, CAPACITY> slots_;
+    std::thread flusher_;
+};
+
+}  // namespace fastlog
+
+#endif /* FASTLOG_HPP_ */
@@ -1,4 +1,4 @@
-/* Generated by Cython 3.0.2 */
+/* Generated by Cython 3.3.0 */
 
 #ifndef __PYX_HAVE__helloc
 #define __PYX_HAVE__helloc
@@ -25,15 +25,13 @@
 #endif
 
 __PYX_EXTERN_C void hello(char *);
+__PYX_EXTERN_C void hello_log(char const *);
 
 #endif /* !__PYX_HAVE_API__helloc */
 
 /* WARNING: the interface of the module init function changed in CPython 3.5. */
 /* It now returns a PyModuleDef instance instead of a PyModule instance. */
 
-#if PY_MAJOR_VERSION < 3
-PyMODINIT_FUNC inithelloc(void);
-#else
 /* WARNING: Use PyImport_AppendInittab("helloc", PyInit_helloc) instead of calling PyInit_helloc directly from Python 3.5 */
 PyMODINIT_FUNC PyInit_helloc(void);
 
@@ -50,6 +48,5 @@ static PyObject* __PYX_WARN_IF_PyInit_helloc_INIT_CALLED(PyObject* res) {
 }
 #define PyInit_helloc() __PYX_WARN_IF_PyInit_helloc_INIT_CALLED(PyInit_helloc())
 #endif
-#endif
 
 #endif /* !__PYX_HAVE__helloc */
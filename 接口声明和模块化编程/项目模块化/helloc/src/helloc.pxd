@@ -1,4 +1,16 @@
+from libcpp cimport bool
 from libcpp.string cimport string
+from libcpp.string_view cimport string_view
 
-cdef float get_nowtime()
+cdef extern from "fastlog.hpp" namespace "fastlog" nogil:
+    cdef cppclass Logger:
+        @staticmethod
+        Logger& instance()
+        # `log`是变参模板,这里只声明用到的参数个数
+        bool log(string_view part) noexcept
+        bool log(string_view part1, string_view part2) noexcept
+        void flush() noexcept
+
+cdef double get_nowtime() noexcept nogil
 cdef public void hello(char* name) except *
+cdef public void hello_log(const char* name) noexcept nogil
@@ -1,11 +1,14 @@
 # distutils: language = c++
 
 from libcpp.string cimport string, to_string
-import time
+from libcpp.string_view cimport string_view
+from posix.time cimport clock_gettime, timespec, CLOCK_REALTIME
 
-cdef float get_nowtime():
-    cdef float now = time.time()
-    return now
+cdef double get_nowtime() noexcept nogil:
+    # 当前的时间戳用float只能精确到百秒量级,这里直接取系统时钟并用double保存
+    cdef timespec ts
+    clock_gettime(CLOCK_REALTIME, &ts)
+    return ts.tv_sec + ts.tv_nsec * 1e-9
 
 cdef void hello(char* name) except *:
     cdef string ts = to_string(get_nowtime())
@@ -13,4 +16,8 @@ cdef void hello(char* name) except *:
     out.append(name)
     out.append(b" now timestamp is ")
     out.append(ts)
-    print(out.decode("utf-8"))
\ No newline at end of file
+    print(out.decode("utf-8"))
+
+cdef void hello_log(const char* name) noexcept nogil:
+    # 不需要GIL,由fastlog的后台线程写到标准输出,时间戳在行首
+    Logger.instance().log(string_view(b"hello "), string_view(name))
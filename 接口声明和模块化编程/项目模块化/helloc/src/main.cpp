@@ -1,12 +1,30 @@
+#include <errno.h>
+#include <signal.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <list>
 #include <string>
+#include <thread>
+#include <vector>
 // #include <Python.h>
+#include "fastlog.hpp"
 #include "helloc.h"
 
 const char* version = "0.1.0";
 
 
-int callmodelhello(char* name) {
+/**
+ * @fn init_helloc
+ * @brief 注册helloc为内置模块,初始化解释器并导入helloc
+ * @return  helloc模块,失败时返回NULL,此时解释器已经回收
+ */
+PyObject* init_helloc() {
     /** Add a built-in module, before Py_Initialize
      *  Py_Initialize执行前 前增加一个默认导入的模块
     */
@@ -21,24 +39,342 @@ int callmodelhello(char* name) {
     if (!helloc_module) {
         PyErr_Print();
         fprintf(stderr, "Error: could not import module 'helloc'\n");
-        goto exit_with_error;
+        Py_Finalize();
+        return NULL;
+        }
+    return helloc_module;
+    }
+
+int callmodelhello(char* name) {
+    PyObject* helloc_module = init_helloc();
+    if (!helloc_module) {
+        return 1;
         }
     hello(name);
     /* Clean up after using CPython. */
+    Py_DECREF(helloc_module);
     Py_Finalize();
     return 0;
-    /**Clean up in the error cases above.*/
-exit_with_error:
+    }
+
+static volatile sig_atomic_t stop_serving = 0;
+
+static void on_stop_signal(int) { stop_serving = 1; }
+
+/**
+ * @fn install_stop_handlers
+ * @brief SIGINT和SIGTERM只设置停止标记,不设置SA_RESTART,阻塞中的read/accept会以EINTR返回
+ * @details 需要在Py_Initialize之后调用,覆盖python自己注册的SIGINT处理函数
+ */
+static void install_stop_handlers() {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_stop_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    }
+
+/**
+ * @fn flush_python_stdout
+ * @brief 刷新python的sys.stdout,`hello`用print输出,不刷新的话输出到管道时会一直留在缓冲中
+ */
+static void flush_python_stdout() {
+    PyObject* out = PySys_GetObject("stdout");  // 借用引用
+    if (!out || out == Py_None) {
+        return;
+        }
+    PyObject* res = PyObject_CallMethod(out, "flush", NULL);
+    if (!res) {
+        PyErr_Print();
+        return;
+        }
+    Py_DECREF(res);
+    }
+
+/**
+ * @fn send_all
+ * @brief 把`data`全部写入套接字,对端关闭时不触发SIGPIPE
+ * @return  0 成功, -1 出错
+ */
+static int send_all(int fd, const std::string& data) {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+                }
+            return -1;
+            }
+        sent += static_cast<std::size_t>(n);
+        }
+    return 0;
+    }
+
+/**
+ * @fn process_batch
+ * @brief 对一批名字依次调用`hello`,然后刷新一次输出
+ * @details 只在调用`hello`和刷新输出期间持有GIL,可以在任意线程调用,已经持有GIL时也可以
+ * @param[names]  名字,处理后清空
+ * @param[out_fd]  每个名字回复一行`ok <名字>`,小于0时不回复
+ * @return  0 成功, -1 回复失败
+ */
+static int process_batch(std::vector<std::string>& names, int out_fd) {
+    std::string reply;
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    for (auto& name : names) {
+        hello(name.data());
+        if (PyErr_Occurred()) {
+            PyErr_Print();
+            }
+        if (out_fd >= 0) {
+            reply += "ok ";
+            reply += name;
+            reply += '\n';
+            }
+        }
+    flush_python_stdout();
+    PyGILState_Release(gstate);
+    names.clear();
+    return out_fd >= 0 ? send_all(out_fd, reply) : 0;
+    }
+
+/**
+ * @fn serve_fd
+ * @brief 从`in_fd`按行读取名字并批量处理
+ * @details 一次read得到的完整行作为一批,超过`batch`个时拆开;
+ *          输入稀疏时每行单独处理,延迟不受批量影响,输入密集时自然合并成批.
+ * @param[in_fd]  输入
+ * @param[out_fd]  回复的套接字,小于0时不回复
+ * @param[batch]  一批的最大名字数
+ * @return  0 读到EOF或者收到停止信号, -1 读写出错
+ */
+static int serve_fd(int in_fd, int out_fd, std::size_t batch) {
+    std::string pending;
+    std::vector<std::string> names;
+    char buf[65536];
+    while (!stop_serving) {
+        ssize_t n = read(in_fd, buf, sizeof(buf));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+                }
+            return -1;
+            }
+        if (n == 0) {
+            break;
+            }
+        pending.append(buf, static_cast<std::size_t>(n));
+        std::size_t begin = 0;
+        std::size_t end;
+        while ((end = pending.find('\n', begin)) != std::string::npos) {
+            std::size_t len = end - begin;
+            if (len > 0 && pending[end - 1] == '\r') {
+                --len;
+                }
+            if (len > 0) {
+                names.emplace_back(pending, begin, len);
+                }
+            begin = end + 1;
+            if (names.size() >= batch && process_batch(names, out_fd) != 0) {
+                return -1;
+                }
+            }
+        pending.erase(0, begin);
+        if (!names.empty() && process_batch(names, out_fd) != 0) {
+            return -1;
+            }
+        }
+    // 最后一行可以没有换行
+    if (!pending.empty() && !stop_serving) {
+        names.push_back(pending);
+        return process_batch(names, out_fd);
+        }
+    return 0;
+    }
+
+/**
+ * @fn servestdin
+ * @brief 常驻模式,解释器只初始化一次,从标准输入逐行读取名字调用`hello`,直到EOF
+ * @param[batch]  一批的最大名字数
+ */
+int servestdin(std::size_t batch) {
+    PyObject* helloc_module = init_helloc();
+    if (!helloc_module) {
+        return 1;
+        }
+    install_stop_handlers();
+    int result = serve_fd(STDIN_FILENO, -1, batch);
+    Py_DECREF(helloc_module);
+    Py_Finalize();
+    return result == 0 ? 0 : 1;
+    }
+
+/**
+ * @brief unix套接字上的一个连接,由自己的线程处理
+ */
+struct UnixClient {
+    int fd = -1;
+    std::thread thread;
+    std::atomic<bool> done{false};
+    };
+
+/**
+ * @fn serveunix
+ * @brief 常驻模式,在unix套接字上接受连接,每个连接按行发送名字,每个名字回复一行`ok <名字>`
+ * @details 每个连接一个线程,读取时不持有GIL,只在调用`hello`时获取,空闲的连接不会挡住其他连接.
+ *          收到SIGINT或SIGTERM后关闭所有连接,删除套接字文件并退出
+ * @param[path]  套接字路径,已存在时先删除
+ * @param[batch]  一批的最大名字数
+ */
+int serveunix(const char* path, std::size_t batch) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: socket path too long\n");
+        return 1;
+        }
+    PyObject* helloc_module = init_helloc();
+    if (!helloc_module) {
+        return 1;
+        }
+    install_stop_handlers();
+    int result = 1;
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if (server < 0 || bind(server, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(server, 16) != 0) {
+        perror("Error: could not listen on unix socket");
+        }
+    else {
+        // 停止信号只由主线程处理,连接线程创建时继承屏蔽了停止信号的掩码
+        sigset_t stop_signals, old_mask;
+        sigemptyset(&stop_signals);
+        sigaddset(&stop_signals, SIGINT);
+        sigaddset(&stop_signals, SIGTERM);
+        std::list<UnixClient> clients;
+        PyThreadState* main_state = PyEval_SaveThread();
+        result = 0;
+        while (!stop_serving) {
+            int conn = accept(server, NULL, NULL);
+            if (conn < 0) {
+                if (errno == EINTR) {
+                    continue;
+                    }
+                perror("Error: accept");
+                result = 1;
+                break;
+                }
+            // 回收已经结束的连接
+            clients.remove_if([](UnixClient& client) {
+                if (!client.done) {
+                    return false;
+                    }
+                client.thread.join();
+                close(client.fd);
+                return true;
+                });
+            auto& client = clients.emplace_back();
+            client.fd = conn;
+            pthread_sigmask(SIG_BLOCK, &stop_signals, &old_mask);
+            client.thread = std::thread([&client, batch] {
+                if (serve_fd(client.fd, client.fd, batch) != 0) {
+                    perror("Warning: connection closed");
+                    }
+                client.done = true;
+                });
+            pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+            }
+        // 唤醒阻塞在read中的连接线程,等它们处理完手上的一批后退出
+        for (auto& client : clients) {
+            shutdown(client.fd, SHUT_RDWR);
+            }
+        for (auto& client : clients) {
+            client.thread.join();
+            close(client.fd);
+            }
+        PyEval_RestoreThread(main_state);
+        }
+    if (server >= 0) {
+        close(server);
+        unlink(path);
+        }
+    Py_DECREF(helloc_module);
+    Py_Finalize();
+    return result;
+    }
+
+/**
+ * @fn run_threads
+ * @brief 启动`threads`个线程,每个线程调用`count`次`func`
+ * @return  从启动到所有线程返回的耗时,单位秒
+ */
+template <typename Func>
+double run_threads(int count, int threads, Func func) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([count, &func] {
+            for (int j = 0; j < count; ++j) {
+                func();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @fn benchhello
+ * @brief 对比多线程高频调用`hello`(GIL和python的print)和`hello_log`(fastlog)的耗时,结果输出到标准错误
+ * @param[count]  每个线程的调用次数
+ * @param[threads]  线程数
+ */
+int benchhello(int count, int threads) {
+    static char name[] = "bench";
+    PyObject* helloc_module = init_helloc();
+    if (!helloc_module) {
+        return 1;
+        }
+    // 主线程释放GIL,工作线程调用`hello`前各自获取
+    PyThreadState* main_state = PyEval_SaveThread();
+    double print_cost = run_threads(count, threads, [] {
+        PyGILState_STATE gstate = PyGILState_Ensure();
+        hello(name);
+        if (PyErr_Occurred()) {
+            PyErr_Print();
+            }
+        PyGILState_Release(gstate);
+    });
+    double log_cost = run_threads(count, threads, [] { hello_log(name); });
+    auto start = std::chrono::steady_clock::now();
+    fastlog::Logger::instance().flush();
+    double flush_cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    PyEval_RestoreThread(main_state);
+    double calls = static_cast<double>(count) * threads;
+    fprintf(stderr, "hello      %d threads x %d calls: %8.3fs %8.1fns/call\n", threads, count, print_cost, print_cost / calls * 1e9);
+    fprintf(stderr, "hello_log  %d threads x %d calls: %8.3fs %8.1fns/call (flush %.3fs, dropped %llu)\n", threads, count,
+            log_cost, log_cost / calls * 1e9, flush_cost, static_cast<unsigned long long>(fastlog::Logger::instance().dropped()));
+    Py_DECREF(helloc_module);
     Py_Finalize();
-    return 1;
+    return 0;
     }
 
 int main(int argc, char** argv) {
 
     int ch;
     int result;
+    int bench_count = 0;
+    int bench_threads = 4;
+    bool serve_stdin = false;
+    const char* socket_path = NULL;
+    std::size_t batch = 64;
     opterr = 0;
-    while ((ch = getopt(argc, argv, "s:v\n")) != -1) {
+    while ((ch = getopt(argc, argv, "s:b:t:iu:n:v\n")) != -1) {
         switch (ch) {
             case 'v':
                 printf("option v: %s\n", version);
@@ -48,9 +384,39 @@ int main(int argc, char** argv) {
                 if (result != 0)
                     printf("callmodelhello get error");
                 break;
+            case 'b':
+                bench_count = atoi(optarg);
+                break;
+            case 't':
+                bench_threads = atoi(optarg);
+                break;
+            case 'i':
+                serve_stdin = true;
+                break;
+            case 'u':
+                socket_path = optarg;
+                break;
+            case 'n':
+                batch = static_cast<std::size_t>(atoi(optarg) > 0 ? atoi(optarg) : 1);
+                break;
             default:
                 printf("wrong args\n");
             }
         }
+    if (bench_count > 0) {
+        result = benchhello(bench_count, bench_threads);
+        if (result != 0)
+            printf("benchhello get error");
+        }
+    if (serve_stdin) {
+        result = servestdin(batch);
+        if (result != 0)
+            printf("servestdin get error");
+        }
+    else if (socket_path) {
+        result = serveunix(socket_path, batch);
+        if (result != 0)
+            printf("serveunix get error");
+        }
     }
 